@@ -1,19 +1,18 @@
 #include "AVLTree.h"
+#include "DateUtils.h"
+#include "Instrumentation.h"
 #include <algorithm>
+#include <climits>
+#include <cmath>
+#include <new>
 
-AVLTree::AVLTree() : root(nullptr) {}
+AVLTree::AVLTree()
+    : root(nullptr), count(0), symbols(std::make_shared<SymbolTable>()),
+      arena(sizeof(Node), alignof(Node)), ownsNodes(true), viewMemory(), copyOnWrite(false), epoch(0) {}
 
-AVLTree::~AVLTree() {
-    destroyTree(root);
-}
-
-void AVLTree::destroyTree(Node* node) {
-    if (node) {
-        destroyTree(node->left);
-        destroyTree(node->right);
-        delete node;
-    }
-}
+// Nodes (including retired ones) live in the arena, which frees its
+// slabs wholesale; views own no nodes and never allocate.
+AVLTree::~AVLTree() {}
 
 int AVLTree::getHeight(Node* node) {
     return node ? node->height : 0;
@@ -23,56 +22,98 @@ int AVLTree::getBalanceFactor(Node* node) {
     return node ? getHeight(node->left) - getHeight(node->right) : 0;
 }
 
+void AVLTree::refresh(Node* node) {
+    node->height = 1 + std::max(getHeight(node->left), getHeight(node->right));
+    node->stats = SubtreeStats::of(node->bar);
+    if (node->left) node->stats.merge(node->left->stats);
+    if (node->right) node->stats.merge(node->right->stats);
+}
+
+Node* AVLTree::newNode(StockKey key, const StockBar& bar) {
+    Node* node = new (arena.allocate()) Node(key, bar);
+    node->epoch = epoch;
+    count++;
+    return node;
+}
+
+// In copy-on-write mode, nodes from an earlier epoch may be visible to
+// published readers, so they are cloned before any change and the
+// original is parked in `retired` instead of being modified or freed.
+Node* AVLTree::writable(Node* node) {
+    if (!copyOnWrite || node->epoch == epoch) return node;
+    Node* copy = new (arena.allocate()) Node(*node);
+    copy->epoch = epoch;
+    retired.push_back(node);
+    return copy;
+}
+
+void AVLTree::releaseNode(Node* node) {
+    if (!copyOnWrite || node->epoch == epoch) arena.release(node);
+    else retired.push_back(node);
+    count--;
+}
+
 Node* AVLTree::rightRotate(Node* y) {
-    Node* x = y->left;
+    MM_PROBE_ROTATE();
+    y = writable(y);
+    Node* x = writable(y->left);
     Node* T2 = x->right;
     x->right = y;
     y->left = T2;
-    y->height = std::max(getHeight(y->left), getHeight(y->right)) + 1;
-    x->height = std::max(getHeight(x->left), getHeight(x->right)) + 1;
+    refresh(y);
+    refresh(x);
     return x;
 }
 
 Node* AVLTree::leftRotate(Node* x) {
-    Node* y = x->right;
+    MM_PROBE_ROTATE();
+    x = writable(x);
+    Node* y = writable(x->right);
     Node* T2 = y->left;
     y->left = x;
     x->right = T2;
-    x->height = std::max(getHeight(x->left), getHeight(x->right)) + 1;
-    y->height = std::max(getHeight(y->left), getHeight(y->right)) + 1;
+    refresh(x);
+    refresh(y);
     return y;
 }
 
-Node* AVLTree::insertNode(Node* node, StockData data) {
-    if (!node) return new Node(data);
+Node* AVLTree::insertNode(Node* node, StockKey key, const StockBar& bar) {
+    if (!node) return newNode(key, bar);
+    MM_PROBE_COMPARE();
     
-    std::string key = data.ticker + data.date;
-    std::string nodeKey = node->data.ticker + node->data.date;
-    
-    if (key < nodeKey) node->left = insertNode(node->left, data);
-    else if (key > nodeKey) node->right = insertNode(node->right, data);
-    else return node;
+    size_t before = count;
+    if (key < node->key) {
+        Node* child = insertNode(node->left, key, bar);
+        if (count == before) return node;
+        node = writable(node);
+        node->left = child;
+    } else if (key > node->key) {
+        Node* child = insertNode(node->right, key, bar);
+        if (count == before) return node;
+        node = writable(node);
+        node->right = child;
+    } else return node;
 
-    node->height = 1 + std::max(getHeight(node->left), getHeight(node->right));
+    refresh(node);
     
     int balance = getBalanceFactor(node);
     
     // Left Left
-    if (balance > 1 && key < (node->left->data.ticker + node->left->data.date))
+    if (balance > 1 && key < node->left->key)
         return rightRotate(node);
     
     // Right Right
-    if (balance < -1 && key > (node->right->data.ticker + node->right->data.date))
+    if (balance < -1 && key > node->right->key)
         return leftRotate(node);
     
     // Left Right
-    if (balance > 1 && key > (node->left->data.ticker + node->left->data.date)) {
+    if (balance > 1 && key > node->left->key) {
         node->left = leftRotate(node->left);
         return rightRotate(node);
     }
     
     // Right Left
-    if (balance < -1 && key < (node->right->data.ticker + node->right->data.date)) {
+    if (balance < -1 && key < node->right->key) {
         node->right = rightRotate(node->right);
         return leftRotate(node);
     }
@@ -80,38 +121,53 @@ Node* AVLTree::insertNode(Node* node, StockData data) {
     return node;
 }
 
+Node* AVLTree::updateNode(Node* node, StockKey key, const StockBar& bar) {
+    MM_PROBE_COMPARE();
+    node = writable(node);
+    if (key < node->key) node->left = updateNode(node->left, key, bar);
+    else if (key > node->key) node->right = updateNode(node->right, key, bar);
+    else node->bar = bar;
+    refresh(node);
+    return node;
+}
+
 Node* AVLTree::minValueNode(Node* node) {
     Node* current = node;
     while (current->left) current = current->left;
     return current;
 }
 
-Node* AVLTree::deleteNode(Node* root, std::string ticker, std::string date) {
+Node* AVLTree::deleteNode(Node* root, StockKey key) {
     if (!root) return root;
+    MM_PROBE_COMPARE();
     
-    std::string key = ticker + date;
-    std::string rootKey = root->data.ticker + root->data.date;
-    
-    if (key < rootKey) root->left = deleteNode(root->left, ticker, date);
-    else if (key > rootKey) root->right = deleteNode(root->right, ticker, date);
-    else {
+    size_t before = count;
+    if (key < root->key) {
+        Node* child = deleteNode(root->left, key);
+        if (count == before) return root;
+        root = writable(root);
+        root->left = child;
+    } else if (key > root->key) {
+        Node* child = deleteNode(root->right, key);
+        if (count == before) return root;
+        root = writable(root);
+        root->right = child;
+    } else {
         if (!root->left || !root->right) {
+            // The remaining child (if any) is a valid, balanced subtree.
             Node* temp = root->left ? root->left : root->right;
-            if (!temp) {
-                temp = root;
-                root = nullptr;
-            } else *root = *temp;
-            delete temp;
+            releaseNode(root);
+            return temp;
         } else {
             Node* temp = minValueNode(root->right);
-            root->data = temp->data;
-            root->right = deleteNode(root->right, temp->data.ticker, temp->data.date);
+            root = writable(root);
+            root->key = temp->key;
+            root->bar = temp->bar;
+            root->right = deleteNode(root->right, root->key);
         }
     }
 
-    if (!root) return root;
-
-    root->height = 1 + std::max(getHeight(root->left), getHeight(root->right));
+    refresh(root);
     int balance = getBalanceFactor(root);
 
     // Rebalance
@@ -128,77 +184,419 @@ Node* AVLTree::deleteNode(Node* root, std::string ticker, std::string date) {
     return root;
 }
 
-Node* AVLTree::searchNode(Node* root, std::string ticker, std::string date) {
-    if (!root) return nullptr;
-    std::string key = ticker + date;
-    std::string rootKey = root->data.ticker + root->data.date;
-    
-    if (key < rootKey) return searchNode(root->left, ticker, date);
-    if (key > rootKey) return searchNode(root->right, ticker, date);
+Node* AVLTree::searchNode(Node* root, StockKey key) const {
+    while (root) {
+        MM_PROBE_COMPARE();
+        if (key == root->key) break;
+        root = key < root->key ? root->left : root->right;
+    }
     return root;
 }
 
-void AVLTree::inOrderTraversal(Node* root, std::vector<StockData>& result) {
-    if (root) {
-        inOrderTraversal(root->left, result);
-        result.push_back(root->data);
-        inOrderTraversal(root->right, result);
+// Resolves an existing ticker and a valid date to a key without interning.
+bool AVLTree::lookupKey(const std::string& ticker, const std::string& date, StockKey& key) const {
+    uint32_t id;
+    int day;
+    if (!symbols->find(ticker, id) || !DateUtils::parseDate(date, day)) return false;
+    key = makeStockKey(id, day);
+    return true;
+}
+
+StockData AVLTree::rowFor(StockKey key, const StockBar& bar) const {
+    return StockData(symbols->name(keyTickerId(key)), DateUtils::toDateString(keyDay(key)),
+                     bar.openPrice, bar.closePrice, bar.highPrice, bar.lowPrice, bar.volume);
+}
+
+void RangeCursor::pushLeftPath(const Node* node) {
+    while (node) {
+        stack[depth++] = node;
+        node = node->left;
+    }
+}
+
+void RangeCursor::next() {
+    const Node* node = stack[--depth];
+    pushLeftPath(node->right);
+}
+
+// Leaves the cursor with the path to the first key >= start on its stack;
+// nodes with smaller keys are skipped rather than pushed.
+RangeCursor AVLTree::seekKeys(StockKey start, StockKey end) const {
+    RangeCursor cursor;
+    cursor.end = end;
+    const Node* node = root;
+    while (node) {
+        MM_PROBE_COMPARE();
+        if (node->key >= start) {
+            cursor.stack[cursor.depth++] = node;
+            node = node->left;
+        } else {
+            node = node->right;
+        }
     }
+    return cursor;
+}
+
+void AVLTree::collectNodes(Node* node, std::vector<Node*>& result) {
+    if (node) {
+        collectNodes(node->left, result);
+        result.push_back(node);
+        collectNodes(node->right, result);
+    }
+}
+
+Node* AVLTree::buildBalanced(std::vector<Node*>& nodes, size_t lo, size_t hi) {
+    if (lo >= hi) return nullptr;
+    size_t mid = lo + (hi - lo) / 2;
+    Node* node = writable(nodes[mid]);
+    node->left = buildBalanced(nodes, lo, mid);
+    node->right = buildBalanced(nodes, mid + 1, hi);
+    refresh(node);
+    return node;
+}
+
+// Copy-on-write support for ConcurrentStore
+void AVLTree::enableCopyOnWrite() {
+    copyOnWrite = true;
+    epoch++;
+}
+
+// Returns a read-only tree sharing this tree's nodes. Nothing in the
+// view may change until beginEpoch() has been called on this tree.
+AVLTree* AVLTree::makeView() const {
+    AVLTree* view = new AVLTree();
+    view->root = root;
+    view->count = count;
+    view->symbols = symbols;
+    view->ownsNodes = false;
+    view->viewMemory = arena.stats();
+    return view;
+}
+
+void AVLTree::beginEpoch(std::vector<Node*>& retiredNodes) {
+    retiredNodes.swap(retired);
+    retired.clear();
+    epoch++;
 }
 
 // Public methods
-void AVLTree::insert(StockData data) {
-    root = insertNode(root, data);
+void AVLTree::notify(const std::string& ticker, int day, MutationKind kind) {
+    for (TreeListener* listener : listeners)
+        listener->onMutation(ticker, day, kind);
+}
+
+void AVLTree::addListener(TreeListener* listener) {
+    listeners.push_back(listener);
+}
+
+void AVLTree::removeListener(TreeListener* listener) {
+    listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
+}
+
+bool AVLTree::insert(const StockData& data) {
+    MM_PROBE_OP(Insert);
+    int day;
+    if (!DateUtils::parseDate(data.date, day)) return false;
+    size_t before = count;
+    root = insertNode(root, makeStockKey(symbols->intern(data.ticker), day), toStockBar(data));
+    if (count != before) notify(data.ticker, day, MutationKind::Insert);
+    return true;
+}
+
+bool AVLTree::search(const std::string& ticker, const std::string& date, StockData& out) const {
+    MM_PROBE_OP(Search);
+    StockKey key;
+    if (!lookupKey(ticker, date, key)) return false;
+    Node* result = searchNode(root, key);
+    if (!result) return false;
+    out = rowFor(result->key, result->bar);
+    return true;
 }
 
-StockData* AVLTree::search(std::string ticker, std::string date) {
-    Node* result = searchNode(root, ticker, date);
-    return result ? &(result->data) : nullptr;
+bool AVLTree::searchBar(const std::string& ticker, int day, StockBar& out) const {
+    MM_PROBE_OP(Search);
+    uint32_t id;
+    if (!symbols->find(ticker, id)) return false;
+    Node* result = searchNode(root, makeStockKey(id, day));
+    if (!result) return false;
+    out = result->bar;
+    return true;
 }
 
-bool AVLTree::update(StockData newData) {
-    Node* node = searchNode(root, newData.ticker, newData.date);
-    if (!node) return false;
-    node->data = newData;
+bool AVLTree::update(const StockData& newData) {
+    MM_PROBE_OP(Update);
+    StockKey key;
+    if (!lookupKey(newData.ticker, newData.date, key)) return false;
+    if (!searchNode(root, key)) return false;
+    // Rewrites the path so every ancestor's subtree stats see the new bar
+    root = updateNode(root, key, toStockBar(newData));
+    notify(newData.ticker, keyDay(key), MutationKind::Update);
     return true;
 }
 
-bool AVLTree::remove(std::string ticker, std::string date) {
-    if (!searchNode(root, ticker, date)) return false;
-    root = deleteNode(root, ticker, date);
+bool AVLTree::remove(const std::string& ticker, const std::string& date) {
+    MM_PROBE_OP(Remove);
+    StockKey key;
+    if (!lookupKey(ticker, date, key) || !searchNode(root, key)) return false;
+    root = deleteNode(root, key);
+    notify(ticker, keyDay(key), MutationKind::Remove);
     return true;
 }
 
-std::vector<StockData> AVLTree::getAllStocks() {
+size_t AVLTree::bulkLoad(const std::vector<StockData>& rows) {
+    MM_PROBE_OP(BulkLoad);
+    std::vector<std::pair<StockKey, size_t>> batch;
+    batch.reserve(rows.size());
+    for (size_t i = 0; i < rows.size(); i++) {
+        int day;
+        if (DateUtils::parseDate(rows[i].date, day))
+            batch.emplace_back(makeStockKey(symbols->intern(rows[i].ticker), day), i);
+    }
+    return loadKeys(batch, [&rows](size_t i) { return toStockBar(rows[i]); });
+}
+
+size_t AVLTree::bulkLoad(const std::vector<std::string>& tickers, const std::vector<TickerBar>& rows) {
+    MM_PROBE_OP(BulkLoad);
+    std::vector<uint32_t> ids(tickers.size());
+    for (size_t t = 0; t < tickers.size(); t++) ids[t] = symbols->intern(tickers[t]);
+    std::vector<std::pair<StockKey, size_t>> batch;
+    batch.reserve(rows.size());
+    for (size_t i = 0; i < rows.size(); i++)
+        batch.emplace_back(makeStockKey(ids[rows[i].ticker], rows[i].day), i);
+    return loadKeys(batch, [&rows](size_t i) { return rows[i].bar; });
+}
+
+// Shared by both bulkLoad overloads: batch holds (key, row index) pairs and
+// barAt(index) yields that row's bar.
+template <typename BarAt>
+size_t AVLTree::loadKeys(std::vector<std::pair<StockKey, size_t>>& batch, BarAt barAt) {
+    auto byKey = [](const std::pair<StockKey, size_t>& a, const std::pair<StockKey, size_t>& b) {
+        return a.first < b.first;
+    };
+    if (!std::is_sorted(batch.begin(), batch.end(), byKey))
+        std::stable_sort(batch.begin(), batch.end(), byKey);
+    batch.erase(std::unique(batch.begin(), batch.end(),
+                            [](const std::pair<StockKey, size_t>& a, const std::pair<StockKey, size_t>& b) {
+                                return a.first == b.first;
+                            }),
+                batch.end());
+
+    // Keys actually added, in key order; duplicates of existing rows are
+    // not reported to listeners.
+    std::vector<StockKey> addedKeys;
+
+    // A small batch against a large tree is cheaper as individual inserts,
+    // decided before paying O(n) to flatten the tree.
+    if (count > 0) {
+        double logN = std::log2(static_cast<double>(count) + 1);
+        if (static_cast<double>(batch.size()) * logN < static_cast<double>(count)) {
+            for (const auto& entry : batch) {
+                if (searchNode(root, entry.first)) continue;
+                root = insertNode(root, entry.first, barAt(entry.second));
+                addedKeys.push_back(entry.first);
+            }
+            notifyLoaded(addedKeys);
+            return addedKeys.size();
+        }
+    }
+
+    std::vector<Node*> existing;
+    existing.reserve(count);
+    collectNodes(root, existing);
+
+    std::vector<Node*> merged;
+    merged.reserve(existing.size() + batch.size());
+    size_t i = 0, j = 0;
+    while (i < existing.size() || j < batch.size()) {
+        if (j == batch.size() || (i < existing.size() && existing[i]->key <= batch[j].first)) {
+            if (j < batch.size() && existing[i]->key == batch[j].first) j++;
+            merged.push_back(existing[i++]);
+        } else {
+            merged.push_back(newNode(batch[j].first, barAt(batch[j].second)));
+            addedKeys.push_back(batch[j].first);
+            j++;
+        }
+    }
+    root = buildBalanced(merged, 0, merged.size());
+    notifyLoaded(addedKeys);
+    return addedKeys.size();
+}
+
+// addedKeys is key-sorted, so the first key per ticker id is the earliest
+// day that ticker gained.
+void AVLTree::notifyLoaded(const std::vector<StockKey>& addedKeys) {
+    for (TreeListener* listener : listeners) {
+        bool everyRow = listener->wantsEveryRow();
+        for (size_t k = 0; k < addedKeys.size(); k++)
+            if (everyRow || k == 0 || keyTickerId(addedKeys[k]) != keyTickerId(addedKeys[k - 1]))
+                listener->onMutation(symbols->name(keyTickerId(addedKeys[k])), keyDay(addedKeys[k]),
+                                     MutationKind::Insert);
+    }
+}
+
+std::vector<StockData> AVLTree::getAllStocks() const {
     std::vector<StockData> result;
-    inOrderTraversal(root, result);
+    result.reserve(count);
+    for (const std::string& ticker : getTickers())
+        for (RangeCursor c = scanTicker(ticker); c.valid(); c.next())
+            result.push_back(row(c));
     return result;
 }
 
-std::vector<StockData> AVLTree::getStocksByTicker(std::string ticker) {
-    std::vector<StockData> all = getAllStocks();
+std::vector<StockData> AVLTree::getStocksByTicker(const std::string& ticker) const {
     std::vector<StockData> result;
-    for (const auto& s : all)
-        if (s.ticker == ticker) result.push_back(s);
+    for (RangeCursor c = scanTicker(ticker); c.valid(); c.next())
+        result.push_back(row(c));
     return result;
 }
 
-std::vector<StockData> AVLTree::getStocksByDateRange(std::string ticker,
-                                                   std::string startDate,
-                                                   std::string endDate) {
-    auto stocks = getStocksByTicker(ticker);
+std::vector<StockData> AVLTree::getStocksByDateRange(const std::string& ticker,
+                                                   const std::string& startDate,
+                                                   const std::string& endDate) const {
     std::vector<StockData> result;
-    for (const auto& s : stocks)
-        if (s.date >= startDate && s.date <= endDate)
-            result.push_back(s);
+    for (RangeCursor c = scanDateRange(ticker, startDate, endDate); c.valid(); c.next())
+        result.push_back(row(c));
     return result;
 }
 
-std::vector<StockData> AVLTree::getMultipleTickers(const std::vector<std::string>& tickers) {
+std::vector<StockData> AVLTree::getMultipleTickers(const std::vector<std::string>& tickers) const {
     std::vector<StockData> result;
-    for (const auto& t : tickers) {
-        auto stocks = getStocksByTicker(t);
-        result.insert(result.end(), stocks.begin(), stocks.end());
-    }
+    for (const auto& t : tickers)
+        for (RangeCursor c = scanTicker(t); c.valid(); c.next())
+            result.push_back(row(c));
     return result;
 }
+
+std::vector<std::string> AVLTree::getTickers() const {
+    std::vector<std::string> tickers;
+    for (uint32_t id = 0, n = static_cast<uint32_t>(symbols->size()); id < n; id++)
+        if (seekKeys(makeStockKey(id, INT_MIN), makeStockKey(id, INT_MAX)).valid())
+            tickers.push_back(symbols->name(id));
+    // Ids follow first-seen order, which differs between runs
+    std::sort(tickers.begin(), tickers.end());
+    return tickers;
+}
+
+bool AVLTree::latestDay(const std::string& ticker, int& day) const {
+    uint32_t id;
+    if (!symbols->find(ticker, id)) return false;
+    const StockKey last = makeStockKey(id, INT_MAX);
+    const Node* best = nullptr;
+    for (const Node* node = root; node;) {
+        if (node->key <= last) {
+            best = node;
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+    if (!best || keyTickerId(best->key) != id) return false;
+    day = keyDay(best->key);
+    return true;
+}
+
+double RangeAggregate::closeVariance() const {
+    if (count == 0) return 0;
+    double mean = meanClose();
+    return std::max(0.0, sumCloseSquares / count - mean * mean);
+}
+
+// Descends to the highest node inside [start, end], then walks its left
+// and right spines toward the bounds. Each in-range node on a spine
+// contributes its own bar plus the whole subtree on its inner side, so
+// only O(log n) nodes are touched.
+bool AVLTree::aggregateKeys(StockKey start, StockKey end, RangeAggregate& out) const {
+    const Node* split = root;
+    while (split && (split->key < start || split->key > end)) {
+        MM_PROBE_COMPARE();
+        split = split->key < start ? split->right : split->left;
+    }
+    if (!split) return false;
+
+    SubtreeStats total = SubtreeStats::of(split->bar);
+    const Node* first = split;
+    const Node* last = split;
+    for (const Node* node = split->left; node;) {
+        MM_PROBE_COMPARE();
+        if (node->key >= start) {
+            total.merge(SubtreeStats::of(node->bar));
+            if (node->right) total.merge(node->right->stats);
+            first = node;
+            node = node->left;
+        } else {
+            node = node->right;
+        }
+    }
+    for (const Node* node = split->right; node;) {
+        MM_PROBE_COMPARE();
+        if (node->key <= end) {
+            total.merge(SubtreeStats::of(node->bar));
+            if (node->left) total.merge(node->left->stats);
+            last = node;
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+
+    out.count = static_cast<size_t>(total.count);
+    out.firstDay = keyDay(first->key);
+    out.lastDay = keyDay(last->key);
+    out.firstOpen = first->bar.openPrice;
+    out.lastClose = last->bar.closePrice;
+    out.high = total.maxHigh;
+    out.low = total.minLow;
+    out.volume = total.totalVolume;
+    out.sumClose = total.sumClose;
+    out.sumCloseSquares = total.sumCloseSquares;
+    return true;
+}
+
+bool AVLTree::aggregateRange(const std::string& ticker, const std::string& startDate,
+                             const std::string& endDate, RangeAggregate& out) const {
+    int startDay, endDay;
+    if (!DateUtils::parseDate(startDate, startDay) || !DateUtils::parseDate(endDate, endDay)) {
+        out = RangeAggregate();
+        return false;
+    }
+    return aggregateDays(ticker, startDay, endDay, out);
+}
+
+bool AVLTree::aggregateDays(const std::string& ticker, int startDay, int endDay, RangeAggregate& out) const {
+    MM_PROBE_OP(Aggregate);
+    out = RangeAggregate();
+    uint32_t id;
+    if (!symbols->find(ticker, id) || startDay > endDay) return false;
+    return aggregateKeys(makeStockKey(id, startDay), makeStockKey(id, endDay), out);
+}
+
+RangeCursor AVLTree::scanAll() const {
+    MM_PROBE_OP(Scan);
+    return seekKeys(0, UINT64_MAX);
+}
+
+RangeCursor AVLTree::scanTicker(const std::string& ticker) const {
+    MM_PROBE_OP(Scan);
+    uint32_t id;
+    if (!symbols->find(ticker, id)) return RangeCursor();
+    return seekKeys(makeStockKey(id, INT_MIN), makeStockKey(id, INT_MAX));
+}
+
+RangeCursor AVLTree::scanDateRange(const std::string& ticker,
+                                   const std::string& startDate,
+                                   const std::string& endDate) const {
+    MM_PROBE_OP(Scan);
+    uint32_t id;
+    int startDay, endDay;
+    if (!symbols->find(ticker, id) || !DateUtils::parseDate(startDate, startDay) ||
+        !DateUtils::parseDate(endDate, endDay) || startDay > endDay)
+        return RangeCursor();
+    return seekKeys(makeStockKey(id, startDay), makeStockKey(id, endDay));
+}
+
+RangeCursor AVLTree::scanDays(const std::string& ticker, int startDay, int endDay) const {
+    MM_PROBE_OP(Scan);
+    uint32_t id;
+    if (!symbols->find(ticker, id) || startDay > endDay) return RangeCursor();
+    return seekKeys(makeStockKey(id, startDay), makeStockKey(id, endDay));
+}
@@ -3,6 +3,11 @@
 
 #include <vector>
 #include <string>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include "SlabAllocator.h"
+#include "SymbolTable.h"
 
 struct StockData {
     std::string ticker;
@@ -20,46 +25,235 @@ struct StockData {
           closePrice(c), highPrice(h), lowPrice(l), volume(v) {}
 };
 
+// What a tree node stores per row; ticker and date live in its key.
+struct StockBar {
+    double openPrice;
+    double closePrice;
+    double highPrice;
+    double lowPrice;
+    long volume;
+};
+
+inline StockBar toStockBar(const StockData& data) {
+    return { data.openPrice, data.closePrice, data.highPrice, data.lowPrice, data.volume };
+}
+
+// Composite (ticker, date) key: interned ticker id in the high 32 bits,
+// day number (sign bit flipped so it orders as unsigned) in the low 32.
+typedef uint64_t StockKey;
+
+inline StockKey makeStockKey(uint32_t tickerId, int day) {
+    return (static_cast<StockKey>(tickerId) << 32) | (static_cast<uint32_t>(day) ^ 0x80000000u);
+}
+
+inline uint32_t keyTickerId(StockKey key) { return static_cast<uint32_t>(key >> 32); }
+inline int keyDay(StockKey key) { return static_cast<int>(static_cast<uint32_t>(key) ^ 0x80000000u); }
+
+// Totals over a node's whole subtree (the node included). Every change
+// to a node's children or bar recomputes them from the two children, so
+// they never drift.
+struct SubtreeStats {
+    double maxHigh;
+    double minLow;
+    double sumClose;
+    double sumCloseSquares;
+    long long totalVolume;
+    uint64_t count;
+
+    static SubtreeStats of(const StockBar& bar) {
+        return { bar.highPrice, bar.lowPrice, bar.closePrice, bar.closePrice * bar.closePrice, bar.volume, 1 };
+    }
+    void merge(const SubtreeStats& other) {
+        if (other.maxHigh > maxHigh) maxHigh = other.maxHigh;
+        if (other.minLow < minLow) minLow = other.minLow;
+        sumClose += other.sumClose;
+        sumCloseSquares += other.sumCloseSquares;
+        totalVolume += other.totalVolume;
+        count += other.count;
+    }
+};
+
+// OHLCV summary of one ticker over a date window.
+struct RangeAggregate {
+    size_t count = 0;
+    int firstDay = 0;
+    int lastDay = 0;
+    double firstOpen = 0;
+    double lastClose = 0;
+    double high = 0;
+    double low = 0;
+    long long volume = 0;
+    double sumClose = 0;
+    double sumCloseSquares = 0;
+
+    double meanClose() const { return count ? sumClose / count : 0; }
+    double closeVariance() const;      // population variance
+};
+
+// A row for AVLTree::bulkLoad that needs no string conversions: `ticker`
+// indexes the names passed alongside.
+struct TickerBar {
+    uint32_t ticker;
+    int day;
+    StockBar bar;
+};
+
+// Trivially destructible, so a tree can drop its nodes slab by slab.
+// 120 bytes on 64-bit builds: 72 for key, bar, links, height and epoch,
+// 48 for the subtree stats.
 struct Node {
-    StockData data;
+    StockKey key;
+    StockBar bar;
+    SubtreeStats stats;
     Node* left;
     Node* right;
     int height;
-    Node(StockData d) : data(d), left(nullptr), right(nullptr), height(1) {}
+    uint32_t epoch;     // copy-on-write generation that created this node
+    Node(StockKey k, const StockBar& b)
+        : key(k), bar(b), stats(SubtreeStats::of(b)), left(nullptr), right(nullptr), height(1), epoch(0) {}
 };
 
+// Forward in-order cursor over [start, end] keys. It holds the path from
+// the root in a fixed array, so seeking and stepping never allocate, and
+// bars are handed out by reference; AVLTree::row() expands one into a
+// StockData. Any insert/remove on the tree invalidates open cursors.
+class RangeCursor {
+public:
+    RangeCursor() : depth(0), end(0) {}
+    bool valid() const { return depth > 0 && stack[depth - 1]->key <= end; }
+    void next();
+    StockKey key() const { return stack[depth - 1]->key; }
+    int day() const { return keyDay(key()); }
+    const StockBar& operator*() const { return stack[depth - 1]->bar; }
+    const StockBar* operator->() const { return &stack[depth - 1]->bar; }
+
+private:
+    friend class AVLTree;
+    static const int MAX_DEPTH = 96;    // AVL height stays below 1.44*log2(n+2)
+    const Node* stack[MAX_DEPTH];
+    int depth;
+    StockKey end;
+    void pushLeftPath(const Node* node);
+};
+
+enum class MutationKind { Insert, Update, Remove };
+
+// Notified after every successful insert, update or remove. A bulkLoad
+// reports one Insert per affected ticker at the earliest day it added.
+class TreeListener {
+public:
+    virtual ~TreeListener() {}
+    virtual void onMutation(const std::string& ticker, int day, MutationKind kind) = 0;
+    // True to hear one Insert per row a bulkLoad adds instead.
+    virtual bool wantsEveryRow() const { return false; }
+};
+
+// Keys order rows by ticker id (first-seen order), then by date. Listings
+// (getAllStocks, getTickers) are alphabetical by ticker instead, so they
+// do not depend on load order.
 class AVLTree {
 private:
+    friend class ConcurrentStore;
+
     Node* root;
+    size_t count;
+    std::shared_ptr<SymbolTable> symbols;   // shared with views
+    SlabAllocator arena;
+    std::vector<TreeListener*> listeners;
+    bool ownsNodes;             // false for read-only views
+    SlabStats viewMemory;       // views: the owner's allocator when the view was made
+    bool copyOnWrite;
+    uint32_t epoch;
+    std::vector<Node*> retired; // replaced nodes still visible to readers
     // Helper functions
     int getHeight(Node* node);
     int getBalanceFactor(Node* node);
+    void refresh(Node* node);   // height and stats from the children
     Node* rightRotate(Node* y);
     Node* leftRotate(Node* x);
-    Node* insertNode(Node* node, StockData data);
+    Node* newNode(StockKey key, const StockBar& bar);
+    Node* writable(Node* node);
+    void releaseNode(Node* node);
+    Node* insertNode(Node* node, StockKey key, const StockBar& bar);
+    Node* updateNode(Node* node, StockKey key, const StockBar& bar);
     Node* minValueNode(Node* node);
-    Node* deleteNode(Node* root, std::string ticker, std::string date);
-    Node* searchNode(Node* root, std::string ticker, std::string date);
-    void inOrderTraversal(Node* root, std::vector<StockData>& result);
-    void destroyTree(Node* node);
+    Node* deleteNode(Node* root, StockKey key);
+    Node* searchNode(Node* root, StockKey key) const;
+    bool lookupKey(const std::string& ticker, const std::string& date, StockKey& key) const;
+    StockData rowFor(StockKey key, const StockBar& bar) const;
+    RangeCursor seekKeys(StockKey start, StockKey end) const;
+    bool aggregateKeys(StockKey start, StockKey end, RangeAggregate& out) const;
+    void notify(const std::string& ticker, int day, MutationKind kind);
+    void notifyLoaded(const std::vector<StockKey>& addedKeys);
+    void collectNodes(Node* node, std::vector<Node*>& result);
+    Node* buildBalanced(std::vector<Node*>& nodes, size_t lo, size_t hi);
+    template <typename BarAt>
+    size_t loadKeys(std::vector<std::pair<StockKey, size_t>>& batch, BarAt barAt);
+
+    // Copy-on-write mode, used by ConcurrentStore
+    void enableCopyOnWrite();
+    AVLTree* makeView() const;
+    void beginEpoch(std::vector<Node*>& retiredNodes);
 
 public:
     AVLTree();
     ~AVLTree();
+    AVLTree(const AVLTree&) = delete;
+    AVLTree& operator=(const AVLTree&) = delete;
     
     // CRUD Operations
-    void insert(StockData data);
-    StockData* search(std::string ticker, std::string date);
-    bool update(StockData newData);
-    bool remove(std::string ticker, std::string date);
+    bool insert(const StockData& data);
+    bool search(const std::string& ticker, const std::string& date, StockData& out) const;
+    bool searchBar(const std::string& ticker, int day, StockBar& out) const;    // no string conversions
+    bool update(const StockData& newData);
+    bool remove(const std::string& ticker, const std::string& date);
+
+    // Bulk insert: sorts the batch by key if needed and builds (or merges
+    // into) a perfectly balanced tree in O(n + m). Duplicate keys keep the
+    // row already in the tree, then the first occurrence in the batch,
+    // matching insert(). Returns the number of rows added.
+    size_t bulkLoad(const std::vector<StockData>& rows);
+    // Same, for rows already split into ticker index, day and bar; used
+    // by Snapshot::loadInto to skip formatting and re-parsing every row.
+    size_t bulkLoad(const std::vector<std::string>& tickers, const std::vector<TickerBar>& rows);
+
+    size_t size() const { return count; }
+    int height() const { return root ? root->height : 0; }
+
+    // Node allocator usage; bytesReserved / size() is the cost per row.
+    SlabStats memoryStats() const { return ownsNodes ? arena.stats() : viewMemory; }
+
+    void addListener(TreeListener* listener);
+    void removeListener(TreeListener* listener);
     
     // Data Retrieval
-    std::vector<StockData> getAllStocks();
-    std::vector<StockData> getStocksByTicker(std::string ticker);
-    std::vector<StockData> getStocksByDateRange(std::string ticker,
-                                              std::string startDate,
-                                              std::string endDate);
-    std::vector<StockData> getMultipleTickers(const std::vector<std::string>& tickers);
+    std::vector<StockData> getAllStocks() const;
+    std::vector<StockData> getStocksByTicker(const std::string& ticker) const;
+    std::vector<StockData> getStocksByDateRange(const std::string& ticker,
+                                              const std::string& startDate,
+                                              const std::string& endDate) const;
+    std::vector<StockData> getMultipleTickers(const std::vector<std::string>& tickers) const;
+
+    // Tickers that currently have at least one row, alphabetically
+    std::vector<std::string> getTickers() const;
+
+    // Most recent day stored for ticker, in O(log n)
+    bool latestDay(const std::string& ticker, int& day) const;
+
+    // Range statistics from the subtree aggregates in O(log n), without
+    // visiting the rows in between. False if the window holds no rows.
+    bool aggregateRange(const std::string& ticker, const std::string& startDate,
+                        const std::string& endDate, RangeAggregate& out) const;
+    bool aggregateDays(const std::string& ticker, int startDay, int endDay, RangeAggregate& out) const;
+
+    // Cursors: O(log n) seek, then O(1) amortized per row
+    StockData row(const RangeCursor& cursor) const { return rowFor(cursor.key(), *cursor); }
+    RangeCursor scanAll() const;
+    RangeCursor scanTicker(const std::string& ticker) const;
+    RangeCursor scanDateRange(const std::string& ticker,
+                              const std::string& startDate,
+                              const std::string& endDate) const;
+    RangeCursor scanDays(const std::string& ticker, int startDay, int endDay) const;
 };
 
 #endif
@@ -0,0 +1,216 @@
+#include "Backtest.h"
+#include "Indicators.h"
+#include <cmath>
+#include <map>
+#include <sstream>
+
+std::string StrategySpec::describe() const {
+    std::ostringstream out;
+    if (kind == StrategyKind::SmaCrossover) {
+        out << "sma(" << fast << "," << slow << ")";
+    } else {
+        out << "breakout(" << fast << "," << multiplier << ")";
+    }
+    return out.str();
+}
+
+std::vector<StrategySpec> smaCrossoverGrid(const std::vector<int>& fast, const std::vector<int>& slow) {
+    std::vector<StrategySpec> grid;
+    for (int f : fast) {
+        for (int s : slow) {
+            if (f > 0 && f < s) grid.push_back({StrategyKind::SmaCrossover, f, s, 0.0});
+        }
+    }
+    return grid;
+}
+
+std::vector<StrategySpec> breakoutGrid(const std::vector<int>& lookbacks, const std::vector<double>& multipliers) {
+    std::vector<StrategySpec> grid;
+    for (int l : lookbacks) {
+        for (double k : multipliers) {
+            if (l > 1) grid.push_back({StrategyKind::VolatilityBreakout, l, 0, k});
+        }
+    }
+    return grid;
+}
+
+namespace {
+    // Rolling mean and std dev of one ticker's closes for one period.
+    struct PeriodSeries {
+        std::vector<double> mean;
+        std::vector<double> stddev;
+    };
+
+    // A ticker's closes plus every indicator series the strategy set needs,
+    // keyed by period. Built once, then read concurrently by all strategies.
+    struct TickerColumns {
+        std::vector<int> dates;
+        std::vector<double> close;
+        std::map<int, PeriodSeries> periods;
+        size_t first = 0;           // simulated window [first, last)
+        size_t last = 0;
+    };
+
+    struct RunResult {
+        bool ran = false;
+        size_t trades = 0;
+        size_t roundTrips = 0;
+        size_t wins = 0;
+        double totalReturn = 0;
+        double sharpe = 0;
+        double maxDrawdown = 0;
+        double commissions = 0;
+    };
+
+    void loadColumns(const AVLTree& tree, const std::string& ticker, const std::vector<int>& periods,
+                     const BacktestConfig& config, TickerColumns& columns) {
+        for (RangeCursor c = tree.scanTicker(ticker); c.valid(); c.next()) {
+            columns.dates.push_back(c.day());
+            columns.close.push_back(c->closePrice);
+        }
+        size_t n = columns.close.size();
+        for (int period : periods) {
+            PeriodSeries& series = columns.periods[period];
+            series.mean.resize(n);
+            series.stddev.resize(n);
+            Indicators::RollingStats window(period);
+            for (size_t i = 0; i < n; i++) {
+                window.push(columns.close[i]);
+                series.mean[i] = window.mean();
+                series.stddev[i] = window.stddev();
+            }
+        }
+        columns.first = std::lower_bound(columns.dates.begin(), columns.dates.end(), config.startDay) - columns.dates.begin();
+        columns.last = std::upper_bound(columns.dates.begin(), columns.dates.end(), config.endDay) - columns.dates.begin();
+    }
+
+    RunResult simulate(const TickerColumns& columns, const StrategySpec& spec, const BacktestConfig& config) {
+        RunResult result;
+        if (columns.first >= columns.last) return result;
+        result.ran = true;
+
+        const PeriodSeries& fast = columns.periods.at(spec.fast);
+        const PeriodSeries* slow = spec.kind == StrategyKind::SmaCrossover ? &columns.periods.at(spec.slow) : nullptr;
+
+        double cash = config.initialCash;
+        long long shares = 0;
+        double entryCost = 0;
+        double prevEquity = cash;
+        double peak = cash;
+        double sumReturns = 0, sumSquares = 0;
+        size_t days = 0;
+
+        for (size_t i = columns.first; i < columns.last; i++) {
+            double price = columns.close[i];
+            bool holding = shares > 0;
+            bool wantLong = holding;
+            double mean = fast.mean[i];
+            if (slow) {
+                double slowMean = slow->mean[i];
+                if (Indicators::hasValue(mean) && Indicators::hasValue(slowMean)) wantLong = mean > slowMean;
+            } else if (Indicators::hasValue(mean)) {
+                wantLong = holding ? price >= mean : price > mean + spec.multiplier * fast.stddev[i];
+            }
+
+            if (wantLong && !holding && price > 0) {
+                long long qty = static_cast<long long>(cash / (price * (1 + config.commission.rate)));
+                while (qty > 0 && qty * price + config.commission(qty * price) > cash) qty--;
+                if (qty > 0) {
+                    double fee = config.commission(qty * price);
+                    entryCost = qty * price + fee;
+                    cash -= entryCost;
+                    shares = qty;
+                    result.commissions += fee;
+                    result.trades++;
+                }
+            } else if (!wantLong && holding) {
+                double value = shares * price;
+                double fee = config.commission(value);
+                cash += value - fee;
+                if (value - fee > entryCost) result.wins++;
+                shares = 0;
+                result.commissions += fee;
+                result.trades++;
+                result.roundTrips++;
+            }
+
+            double equity = cash + shares * price;
+            if (i > columns.first && prevEquity > 0) {
+                double r = equity / prevEquity - 1;
+                sumReturns += r;
+                sumSquares += r * r;
+                days++;
+            }
+            prevEquity = equity;
+            if (equity > peak) peak = equity;
+            if (peak > 0) result.maxDrawdown = std::max(result.maxDrawdown, (peak - equity) / peak * 100);
+        }
+
+        result.totalReturn = (prevEquity / config.initialCash - 1) * 100;
+        if (days > 1) {
+            double mean = sumReturns / days;
+            double variance = sumSquares / days - mean * mean;
+            if (variance > 0) result.sharpe = mean / std::sqrt(variance) * std::sqrt(252.0);
+        }
+        return result;
+    }
+}
+
+std::vector<StrategyStats> runBacktests(const AVLTree& tree, const std::vector<std::string>& tickers,
+                                        const std::vector<StrategySpec>& strategies,
+                                        const BacktestConfig& config, ThreadPool& pool) {
+    std::vector<StrategyStats> stats(strategies.size());
+    for (size_t s = 0; s < strategies.size(); s++) stats[s].spec = strategies[s];
+    if (strategies.empty() || tickers.empty()) return stats;
+
+    std::vector<int> periods;
+    for (const StrategySpec& spec : strategies) {
+        periods.push_back(spec.fast);
+        if (spec.kind == StrategyKind::SmaCrossover) periods.push_back(spec.slow);
+    }
+    std::sort(periods.begin(), periods.end());
+    periods.erase(std::unique(periods.begin(), periods.end()), periods.end());
+
+    // Tickers go through in batches so only a bounded number of column
+    // sets is resident; within a batch every (ticker, strategy) pair is an
+    // independent task writing its own result slot.
+    const size_t batchSize = std::max<size_t>(16, pool.size() * 2);
+    std::vector<TickerColumns> columns;
+    std::vector<RunResult> results;
+    for (size_t begin = 0; begin < tickers.size(); begin += batchSize) {
+        size_t count = std::min(batchSize, tickers.size() - begin);
+        columns.assign(count, TickerColumns());
+        pool.parallelFor(count, [&](size_t t) {
+            loadColumns(tree, tickers[begin + t], periods, config, columns[t]);
+        });
+
+        results.assign(count * strategies.size(), RunResult());
+        pool.parallelFor(results.size(), [&](size_t i) {
+            results[i] = simulate(columns[i / strategies.size()], strategies[i % strategies.size()], config);
+        });
+
+        for (size_t i = 0; i < results.size(); i++) {
+            const RunResult& r = results[i];
+            if (!r.ran) continue;
+            StrategyStats& s = stats[i % strategies.size()];
+            if (s.tickers == 0 || r.totalReturn > s.bestReturn) s.bestReturn = r.totalReturn;
+            if (s.tickers == 0 || r.totalReturn < s.worstReturn) s.worstReturn = r.totalReturn;
+            s.tickers++;
+            s.trades += r.trades;
+            s.roundTrips += r.roundTrips;
+            s.wins += r.wins;
+            s.meanReturn += r.totalReturn;
+            s.meanSharpe += r.sharpe;
+            s.meanMaxDrawdown += r.maxDrawdown;
+            s.commissions += r.commissions;
+        }
+    }
+
+    for (StrategyStats& s : stats) {
+        if (s.tickers == 0) continue;
+        s.meanReturn /= s.tickers;
+        s.meanSharpe /= s.tickers;
+        s.meanMaxDrawdown /= s.tickers;
+    }
+    return stats;
+}
@@ -0,0 +1,70 @@
+#ifndef BACKTEST_H
+#define BACKTEST_H
+
+#include "AVLTree.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Commission charged per trade; the menu's trade simulator uses the same
+// model: max($5, 1% of the trade value).
+struct CommissionModel {
+    double minimum = 5.0;
+    double rate = 0.01;
+
+    double operator()(double value) const { return std::max(minimum, value * rate); }
+};
+
+enum class StrategyKind { SmaCrossover, VolatilityBreakout };
+
+// SmaCrossover: long while SMA(fast) > SMA(slow), flat otherwise.
+// VolatilityBreakout: enter when close > SMA(lookback) + multiplier *
+// stddev(lookback), exit when close falls below SMA(lookback).
+struct StrategySpec {
+    StrategyKind kind;
+    int fast;               // SMA crossover fast period, or breakout lookback
+    int slow;               // SMA crossover slow period (unused by breakout)
+    double multiplier;      // breakout band width in standard deviations
+
+    std::string describe() const;
+};
+
+// Parameter grids; crossover pairs with fast >= slow are skipped.
+std::vector<StrategySpec> smaCrossoverGrid(const std::vector<int>& fast, const std::vector<int>& slow);
+std::vector<StrategySpec> breakoutGrid(const std::vector<int>& lookbacks, const std::vector<double>& multipliers);
+
+struct BacktestConfig {
+    double initialCash = 100000;
+    CommissionModel commission;
+    int startDay = INT32_MIN;       // simulated window; indicators warm up on earlier history
+    int endDay = INT32_MAX;
+};
+
+// One strategy aggregated over every ticker it ran on. Trades are all-in,
+// long-only, in whole shares at the close; open positions are marked to
+// the last close. Returns and drawdowns are percentages.
+struct StrategyStats {
+    StrategySpec spec;
+    size_t tickers = 0;
+    size_t trades = 0;              // buys + sells
+    size_t roundTrips = 0;
+    size_t wins = 0;                // round trips that beat their entry cost
+    double meanReturn = 0;
+    double bestReturn = 0;
+    double worstReturn = 0;
+    double meanSharpe = 0;          // annualized from daily equity returns
+    double meanMaxDrawdown = 0;
+    double commissions = 0;
+};
+
+// Runs every strategy on every ticker, in parallel over (ticker, strategy)
+// pairs. Each ticker's closes are read from the tree once into columns,
+// and each distinct indicator period is computed once per ticker and
+// shared by every strategy that uses it. Results follow `strategies`.
+std::vector<StrategyStats> runBacktests(const AVLTree& tree, const std::vector<std::string>& tickers,
+                                        const std::vector<StrategySpec>& strategies,
+                                        const BacktestConfig& config, ThreadPool& pool);
+
+#endif
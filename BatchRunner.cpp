@@ -0,0 +1,724 @@
+#include "BatchRunner.h"
+#include "Backtest.h"
+#include "CompressedStore.h"
+#include "Correlation.h"
+#include "CsvExporter.h"
+#include "CsvLoader.h"
+#include "DateUtils.h"
+#include "FinancialMetrics.h"
+#include "Instrumentation.h"
+#include "MetricsCache.h"
+#include "Resampler.h"
+#include "Screener.h"
+#include "Snapshot.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Cell {
+    std::string text;
+    bool number;
+};
+
+struct CommandResult {
+    bool ok = true;
+    std::string error;
+    std::vector<std::string> columns;
+    std::vector<std::vector<Cell>> rows;
+    double seconds = 0;
+};
+
+struct BatchCommand {
+    size_t index;
+    std::string text;
+    std::vector<std::string> args;
+};
+
+Cell number(double v) {
+    char buf[32];
+    auto res = std::to_chars(buf, buf + sizeof(buf), v);
+    return { std::string(buf, res.ptr), true };
+}
+
+Cell number(long long v) {
+    return { std::to_string(v), true };
+}
+
+Cell text(const std::string& s) {
+    return { s, false };
+}
+
+const std::vector<std::string> ROW_COLUMNS = { "ticker", "date", "open", "close", "high", "low", "volume" };
+
+std::vector<Cell> stockRow(const StockData& s) {
+    return { text(s.ticker), text(s.date), number(s.openPrice), number(s.closePrice),
+             number(s.highPrice), number(s.lowPrice), number(static_cast<long long>(s.volume)) };
+}
+
+bool mutates(const std::string& verb) {
+    return verb == "import-csv" || verb == "import-api" || verb == "sync" || verb == "load-snapshot";
+}
+
+// Two of these in one parallel group could write the same file at once,
+// and a later command may read what they wrote.
+bool writesFile(const std::string& verb) {
+    return verb == "export" || verb == "dump-metrics";
+}
+
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        if (!item.empty()) items.push_back(item);
+    return items;
+}
+
+// "*" (or a missing argument) means "no filter".
+std::string optionalArg(const BatchCommand& cmd, size_t i) {
+    return (i < cmd.args.size() && cmd.args[i] != "*") ? cmd.args[i] : std::string();
+}
+
+// Date argument as a day number; "*" or a missing argument gives `fallback`.
+bool optionalDay(const BatchCommand& cmd, size_t i, int fallback, int& day) {
+    std::string date = optionalArg(cmd, i);
+    day = fallback;
+    return date.empty() || DateUtils::parseDate(date, day);
+}
+
+const std::vector<std::string> RANGE_STATS_COLUMNS = { "ticker", "first_date", "last_date", "rows", "open", "close",
+                                                      "high", "low", "volume", "mean_close", "close_stddev" };
+
+std::vector<Cell> rangeStatsRow(const std::string& ticker, const RangeAggregate& a) {
+    return { text(ticker), text(DateUtils::toDateString(a.firstDay)), text(DateUtils::toDateString(a.lastDay)),
+             number(static_cast<long long>(a.count)), number(a.firstOpen), number(a.lastClose), number(a.high),
+             number(a.low), number(a.volume), number(a.meanClose()), number(std::sqrt(a.closeVariance())) };
+}
+
+const std::vector<std::string> METRICS_COLUMNS = { "ticker", "rows", "sma20", "ema50", "volatility" };
+
+// Checks "B|S QUANTITY", then prices the trade at the day's close.
+void tradeResult(const BatchCommand& cmd, bool found, const StockData& stock, CommandResult& r) {
+    char side = static_cast<char>(toupper(static_cast<unsigned char>(cmd.args[3][0])));
+    long long quantity = std::atoll(cmd.args[4].c_str());
+    r.ok = false;
+    if ((side != 'B' && side != 'S') || quantity <= 0) {
+        r.error = "expected B|S and a positive quantity";
+        return;
+    }
+    if (!found) {
+        r.error = "no price for " + cmd.args[1] + " on " + cmd.args[2];
+        return;
+    }
+    r.ok = true;
+    double total = stock.closePrice * quantity;
+    double commission = CommissionModel()(total);
+    r.columns = { "ticker", "date", "side", "quantity", "price", "commission", "net" };
+    r.rows.push_back({ text(stock.ticker), text(stock.date), text(std::string(1, side)), number(quantity),
+                       number(stock.closePrice), number(commission),
+                       number(side == 'B' ? total + commission : total - commission) });
+}
+
+// Parses "export FILE [TICKERS|*] [START|*] [END|*]".
+CsvExportFilter exportFilter(const BatchCommand& cmd) {
+    CsvExportFilter filter;
+    std::string tickers = optionalArg(cmd, 2);
+    if (!tickers.empty()) filter.tickers = splitList(tickers);
+    filter.startDate = optionalArg(cmd, 3);
+    filter.endDate = optionalArg(cmd, 4);
+    return filter;
+}
+
+const std::vector<std::string> COMPRESSION_COLUMNS = { "rows", "blocks", "raw_bytes", "stored_bytes", "ratio", "bytes_per_row" };
+
+std::vector<Cell> compressionRow(const CompressionStats& st) {
+    return { number(static_cast<long long>(st.rows)), number(static_cast<long long>(st.blocks)),
+             number(static_cast<long long>(st.rawBytes)), number(static_cast<long long>(st.storedBytes)),
+             number(st.ratio()), number(st.bytesPerRow()) };
+}
+
+// "dump-metrics FILE [json|prometheus]"; tree stats are left out without a tree.
+void writeMetrics(const BatchCommand& cmd, const AVLTree* tree, CommandResult& r) {
+    std::string format = cmd.args.size() > 2 ? cmd.args[2] : "json";
+    r.ok = false;
+    if (format != "json" && format != "prometheus") {
+        r.error = "expected json or prometheus";
+        return;
+    }
+    std::ofstream file(cmd.args[1]);
+    if (file.is_open()) {
+        if (format == "json") Instrumentation::writeJson(file, tree);
+        else Instrumentation::writePrometheus(file, tree);
+    }
+    if (!file.is_open() || !file.flush()) {
+        r.error = "cannot write " + cmd.args[1];
+        return;
+    }
+    r.ok = true;
+    r.columns = { "file", "format" };
+    r.rows.push_back({ text(cmd.args[1]), text(format) });
+}
+
+class BatchExecutor {
+private:
+    AVLTree& tree;
+    const BatchOptions& options;
+    MetricsCache cache;     // lookups are thread-safe; invalidated by tree mutations
+    ResampleCache levels;   // same, repaired on the next read after a mutation
+
+    void fail(CommandResult& r, const std::string& error) {
+        r.ok = false;
+        r.error = error;
+    }
+
+    void search(const BatchCommand& cmd, CommandResult& r) {
+        r.columns = ROW_COLUMNS;
+        StockData stock;
+        if (tree.search(cmd.args[1], cmd.args[2], stock)) r.rows.push_back(stockRow(stock));
+    }
+
+    void ticker(const BatchCommand& cmd, CommandResult& r) {
+        r.columns = ROW_COLUMNS;
+        for (RangeCursor c = tree.scanTicker(cmd.args[1]); c.valid(); c.next())
+            r.rows.push_back(stockRow(tree.row(c)));
+    }
+
+    void range(const BatchCommand& cmd, CommandResult& r) {
+        r.columns = ROW_COLUMNS;
+        for (RangeCursor c = tree.scanDateRange(cmd.args[1], cmd.args[2], cmd.args[3]); c.valid(); c.next())
+            r.rows.push_back(stockRow(tree.row(c)));
+    }
+
+    void rangeStats(const BatchCommand& cmd, CommandResult& r) {
+        r.columns = RANGE_STATS_COLUMNS;
+        RangeAggregate a;
+        if (!tree.aggregateRange(cmd.args[1], cmd.args[2], cmd.args[3], a)) return;
+        r.rows.push_back(rangeStatsRow(cmd.args[1], a));
+    }
+
+    void resampleBars(const BatchCommand& cmd, CommandResult& r) {
+        BarPeriod period;
+        if (!BarPeriod::parse(cmd.args[2], period)) return fail(r, "expected week, month or <N>d");
+        int startDay, endDay;
+        if (!optionalDay(cmd, 3, INT_MIN, startDay) || !optionalDay(cmd, 4, INT_MAX, endDay))
+            return fail(r, "expected YYYY-MM-DD or *");
+        r.columns = { "ticker", "period_start", "first_date", "last_date", "open", "close", "high", "low", "volume", "rows" };
+        for (const ResampledBar& b : levels.bars(cmd.args[1], period, startDay, endDay))
+            r.rows.push_back({ text(cmd.args[1]), text(DateUtils::toDateString(b.startDay)),
+                               text(DateUtils::toDateString(b.firstDay)), text(DateUtils::toDateString(b.lastDay)),
+                               number(b.openPrice), number(b.closePrice), number(b.highPrice), number(b.lowPrice),
+                               number(b.volume), number(static_cast<long long>(b.rows)) });
+    }
+
+    void metrics(const BatchCommand& cmd, CommandResult& r) {
+        const std::string& t = cmd.args[1];
+        size_t rows = 0;
+        for (RangeCursor c = tree.scanTicker(t); c.valid(); c.next()) rows++;
+        if (rows == 0) return fail(r, "no data for " + t);
+        r.columns = METRICS_COLUMNS;
+        r.rows.push_back({ text(t), number(static_cast<long long>(rows)), number(cache.sma(t, 20)),
+                           number(cache.ema(t, 50)), number(cache.volatility(t)) });
+    }
+
+    void trade(const BatchCommand& cmd, CommandResult& r) {
+        StockData stock;
+        bool found = tree.search(cmd.args[1], cmd.args[2], stock);
+        tradeResult(cmd, found, stock, r);
+    }
+
+    void backtest(const BatchCommand& cmd, CommandResult& r) {
+        std::vector<StrategySpec> strategies;
+        std::vector<int> periods;
+        for (const std::string& p : splitList(cmd.args[2])) periods.push_back(std::atoi(p.c_str()));
+        if (cmd.args[1] == "sma") {
+            std::vector<int> slow;
+            for (const std::string& p : splitList(cmd.args[3])) slow.push_back(std::atoi(p.c_str()));
+            strategies = smaCrossoverGrid(periods, slow);
+        } else if (cmd.args[1] == "breakout") {
+            std::vector<double> widths;
+            for (const std::string& k : splitList(cmd.args[3])) widths.push_back(std::atof(k.c_str()));
+            strategies = breakoutGrid(periods, widths);
+        } else {
+            return fail(r, "expected sma or breakout");
+        }
+        if (strategies.empty()) return fail(r, "no valid parameter combinations");
+        std::string tickers = optionalArg(cmd, 4);
+        std::vector<StrategyStats> stats = runBacktests(tree, tickers.empty() ? tree.getTickers() : splitList(tickers),
+                                                        strategies, BacktestConfig(), ThreadPool::shared());
+        r.columns = { "strategy", "tickers", "trades", "win_rate", "mean_return", "best_return",
+                      "worst_return", "sharpe", "max_drawdown", "commissions" };
+        for (const StrategyStats& s : stats) {
+            r.rows.push_back({ text(s.spec.describe()), number(static_cast<long long>(s.tickers)),
+                               number(static_cast<long long>(s.trades)),
+                               number(s.roundTrips ? 100.0 * s.wins / s.roundTrips : 0.0),
+                               number(s.meanReturn), number(s.bestReturn), number(s.worstReturn),
+                               number(s.meanSharpe), number(s.meanMaxDrawdown), number(s.commissions) });
+        }
+    }
+
+    void correlate(const BatchCommand& cmd, CommandResult& r) {
+        int startDay, endDay;
+        if (!optionalDay(cmd, 2, INT_MIN, startDay) || !optionalDay(cmd, 3, INT_MAX, endDay))
+            return fail(r, "expected YYYY-MM-DD or *");
+        std::string tickers = optionalArg(cmd, 1);
+        CorrelationMatrix matrix;
+        std::string error;
+        if (!matrix.build(tree, tickers.empty() ? tree.getTickers() : splitList(tickers), startDay, endDay,
+                          ThreadPool::shared(), error))
+            return fail(r, error);
+        r.columns = { "ticker_a", "ticker_b", "covariance", "correlation", "observations" };
+        const std::vector<std::string>& names = matrix.tickers();
+        for (size_t i = 0; i < matrix.size(); i++) {
+            for (size_t j = i + 1; j < matrix.size(); j++) {
+                r.rows.push_back({ text(names[i]), text(names[j]), number(matrix.covariance(i, j)),
+                                   number(matrix.correlation(i, j)),
+                                   number(static_cast<long long>(matrix.observations())) });
+            }
+        }
+    }
+
+    // Encodes a copy of the store the way CompressedStore keeps history and
+    // reports what it would cost resident.
+    // Encodes a copy of the tree to show what --store compressed would save.
+    void compressStats(const BatchCommand&, CommandResult& r) {
+        CompressedStore store;
+        store.loadFrom(tree);
+        CompressionStats st = store.stats();
+        SlabStats memory = tree.memoryStats();
+        r.columns = COMPRESSION_COLUMNS;
+        r.columns.push_back("tree_bytes_per_row");
+        r.rows.push_back(compressionRow(st));
+        r.rows.back().push_back(number(st.rows ? static_cast<double>(memory.bytesReserved) / st.rows : 0.0));
+    }
+
+    void screen(const BatchCommand& cmd, CommandResult& r) {
+        ScreenQuery query;
+        if (!parseScreenMetric(cmd.args[1], query.metric)) return fail(r, "expected return, change, volatility or volume");
+        if (cmd.args[2] != "top" && cmd.args[2] != "bottom") return fail(r, "expected top or bottom");
+        query.descending = cmd.args[2] == "top";
+        query.limit = static_cast<size_t>(std::max(0, std::atoi(cmd.args[3].c_str())));
+        if (!optionalDay(cmd, 4, INT_MIN, query.startDay) || !optionalDay(cmd, 5, INT_MAX, query.endDay))
+            return fail(r, "expected YYYY-MM-DD or *");
+        if (cmd.args.size() > 6) query.minAverageVolume = std::atof(cmd.args[6].c_str());
+        r.columns = { "rank", "ticker", screenMetricName(query.metric), "first_date", "last_date",
+                      "first_close", "last_close", "avg_volume", "rows" };
+        std::vector<ScreenResult> results = runScreen(tree, query, ThreadPool::shared());
+        for (size_t i = 0; i < results.size(); i++) {
+            const ScreenResult& s = results[i];
+            r.rows.push_back({ number(static_cast<long long>(i + 1)), text(s.ticker), number(s.value),
+                               text(DateUtils::toDateString(s.firstDay)), text(DateUtils::toDateString(s.lastDay)),
+                               number(s.firstClose), number(s.lastClose), number(s.averageVolume),
+                               number(static_cast<long long>(s.rows)) });
+        }
+    }
+
+    void exportRows(const BatchCommand& cmd, CommandResult& r) {
+        CsvExportFilter filter = exportFilter(cmd);
+        std::string error;
+        if (!CsvExporter::checkDates(filter, error)) return fail(r, error);
+        size_t written = 0;
+        if (!CsvExporter::exportFile(tree, cmd.args[1], filter, written)) return fail(r, "cannot write " + cmd.args[1]);
+        r.columns = { "file", "rows" };
+        r.rows.push_back({ text(cmd.args[1]), number(static_cast<long long>(written)) });
+    }
+
+    void dumpMetrics(const BatchCommand& cmd, CommandResult& r) {
+        writeMetrics(cmd, &tree, r);
+    }
+
+    void importCsv(const BatchCommand& cmd, CommandResult& r) {
+        CsvLoadResult result;
+        size_t before = tree.size();
+        if (!CsvLoader::importFile(tree, cmd.args[1], result)) return fail(r, "cannot open " + cmd.args[1]);
+        r.columns = { "file", "rows", "added", "errors" };
+        r.rows.push_back({ text(cmd.args[1]), number(static_cast<long long>(result.rows.size())),
+                           number(static_cast<long long>(tree.size() - before)),
+                           number(static_cast<long long>(result.errorCount)) });
+    }
+
+    void loadSnapshot(const BatchCommand& cmd, CommandResult& r) {
+        Snapshot snapshot;
+        std::string error;
+        if (!snapshot.open(cmd.args[1], true, error)) return fail(r, error);
+        r.columns = { "file", "added" };
+        r.rows.push_back({ text(cmd.args[1]), number(static_cast<long long>(snapshot.loadInto(tree))) });
+    }
+
+    void importApi(const BatchCommand& cmd, CommandResult& r, bool incremental) {
+        if (!options.api) return fail(r, "no API configuration");
+        std::vector<std::string> symbols = cmd.args.size() > 1 ? splitList(cmd.args[1]) : tree.getTickers();
+        ApiImportResult result;
+        bool ok = incremental ? syncSymbols(tree, symbols, *options.api, result)
+                              : importSymbols(tree, symbols, *options.api, result);
+        if (!result.error.empty()) return fail(r, result.error);
+        r.columns = { "symbols", "requests", "retries", "fetched", "added", "failed" };
+        r.rows.push_back({ number(static_cast<long long>(symbols.size())),
+                           number(static_cast<long long>(result.requests)),
+                           number(static_cast<long long>(result.retries)),
+                           number(static_cast<long long>(result.rowsFetched)),
+                           number(static_cast<long long>(result.rowsInserted)),
+                           number(static_cast<long long>(result.failed.size())) });
+        if (!ok) fail(r, "could not fetch " + std::to_string(result.failed.size()) + " symbols");
+    }
+
+public:
+    BatchExecutor(AVLTree& tree, const BatchOptions& options) : tree(tree), options(options), cache(tree), levels(tree) {}
+
+    void execute(const BatchCommand& cmd, CommandResult& r) {
+        Clock::time_point start = Clock::now();
+        const std::string& verb = cmd.args[0];
+        size_t argc = cmd.args.size() - 1;
+        if (verb == "search" && argc == 2) search(cmd, r);
+        else if (verb == "ticker" && argc == 1) ticker(cmd, r);
+        else if (verb == "range" && argc == 3) range(cmd, r);
+        else if (verb == "range-stats" && argc == 3) rangeStats(cmd, r);
+        else if (verb == "resample" && argc >= 2 && argc <= 4) resampleBars(cmd, r);
+        else if (verb == "metrics" && argc == 1) metrics(cmd, r);
+        else if (verb == "trade" && argc == 4) trade(cmd, r);
+        else if (verb == "export" && argc >= 1 && argc <= 4) exportRows(cmd, r);
+        else if (verb == "backtest" && (argc == 3 || argc == 4)) backtest(cmd, r);
+        else if (verb == "correlate" && argc >= 1 && argc <= 3) correlate(cmd, r);
+        else if (verb == "compress-stats" && argc == 0) compressStats(cmd, r);
+        else if (verb == "screen" && argc >= 3 && argc <= 6) screen(cmd, r);
+        else if (verb == "dump-metrics" && (argc == 1 || argc == 2)) dumpMetrics(cmd, r);
+        else if (verb == "import-csv" && argc == 1) importCsv(cmd, r);
+        else if (verb == "load-snapshot" && argc == 1) loadSnapshot(cmd, r);
+        else if (verb == "import-api" && argc == 1) importApi(cmd, r, false);
+        else if (verb == "sync" && argc <= 1) importApi(cmd, r, true);
+        else fail(r, "unknown command or wrong number of arguments");
+        r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+};
+
+// Inserts every row of `from` into `to`; returns how many were new.
+size_t copyRows(const HistoryStore& from, HistoryStore& to) {
+    size_t before = to.size();
+    for (const std::string& ticker : from.getTickers())
+        for (const StockData& row : from.getStocksByTicker(ticker)) to.insert(row);
+    to.compact();
+    return to.size() - before;
+}
+
+// Runs the commands that need only rows and close columns against a
+// HistoryStore ("--store"). The rest need the tree's cursors, subtree
+// aggregates or listeners and are reported as unavailable.
+class HistoryExecutor {
+private:
+    HistoryStore& store;
+
+    void fail(CommandResult& r, const std::string& error) {
+        r.ok = false;
+        r.error = error;
+    }
+
+    void rows(const std::vector<StockData>& stocks, CommandResult& r) {
+        r.columns = ROW_COLUMNS;
+        r.rows.reserve(stocks.size());
+        for (const StockData& s : stocks) r.rows.push_back(stockRow(s));
+    }
+
+    void search(const BatchCommand& cmd, CommandResult& r) {
+        r.columns = ROW_COLUMNS;
+        StockData stock;
+        if (store.search(cmd.args[1], cmd.args[2], stock)) r.rows.push_back(stockRow(stock));
+    }
+
+    // Folds the window's rows the way AVLTree::aggregateRange does from subtree stats.
+    void rangeStats(const BatchCommand& cmd, CommandResult& r) {
+        r.columns = RANGE_STATS_COLUMNS;
+        std::vector<StockData> window = store.getStocksByDateRange(cmd.args[1], cmd.args[2], cmd.args[3]);
+        if (window.empty()) return;
+        RangeAggregate a;
+        DateUtils::parseDate(window.front().date, a.firstDay);
+        DateUtils::parseDate(window.back().date, a.lastDay);
+        a.firstOpen = window.front().openPrice;
+        a.lastClose = window.back().closePrice;
+        a.high = window.front().highPrice;
+        a.low = window.front().lowPrice;
+        for (const StockData& s : window) {
+            a.count++;
+            a.high = std::max(a.high, s.highPrice);
+            a.low = std::min(a.low, s.lowPrice);
+            a.volume += s.volume;
+            a.sumClose += s.closePrice;
+            a.sumCloseSquares += s.closePrice * s.closePrice;
+        }
+        r.rows.push_back(rangeStatsRow(cmd.args[1], a));
+    }
+
+    // Same values as MetricsCache, computed straight from the close column.
+    void metrics(const BatchCommand& cmd, CommandResult& r) {
+        const std::string& t = cmd.args[1];
+        std::vector<double> closes = store.closes(t, INT_MIN, INT_MAX);
+        if (closes.empty()) return fail(r, "no data for " + t);
+        r.columns = METRICS_COLUMNS;
+        r.rows.push_back({ text(t), number(static_cast<long long>(closes.size())),
+                           number(FinancialMetrics::calculateSMA(closes, 20)),
+                           number(FinancialMetrics::calculateEMA(closes, 50)),
+                           number(FinancialMetrics::calculateVolatility(closes)) });
+    }
+
+    void trade(const BatchCommand& cmd, CommandResult& r) {
+        StockData stock;
+        bool found = store.search(cmd.args[1], cmd.args[2], stock);
+        tradeResult(cmd, found, stock, r);
+    }
+
+    void exportRows(const BatchCommand& cmd, CommandResult& r) {
+        CsvExportFilter filter = exportFilter(cmd);
+        std::string error;
+        if (!CsvExporter::checkDates(filter, error)) return fail(r, error);
+        size_t written = 0;
+        if (!CsvExporter::exportFile(store, cmd.args[1], filter, written)) return fail(r, "cannot write " + cmd.args[1]);
+        r.columns = { "file", "rows" };
+        r.rows.push_back({ text(cmd.args[1]), number(static_cast<long long>(written)) });
+    }
+
+    void importCsv(const BatchCommand& cmd, CommandResult& r) {
+        CsvLoadResult result;
+        size_t before = store.size();
+        if (!CsvLoader::importFile(store, cmd.args[1], result)) return fail(r, "cannot open " + cmd.args[1]);
+        store.compact();
+        r.columns = { "file", "rows", "added", "errors" };
+        r.rows.push_back({ text(cmd.args[1]), number(static_cast<long long>(result.rows.size())),
+                           number(static_cast<long long>(store.size() - before)),
+                           number(static_cast<long long>(result.errorCount)) });
+    }
+
+    void loadSnapshot(const BatchCommand& cmd, CommandResult& r) {
+        Snapshot snapshot;
+        std::string error;
+        if (!snapshot.open(cmd.args[1], true, error)) return fail(r, error);
+        r.columns = { "file", "added" };
+        r.rows.push_back({ text(cmd.args[1]), number(static_cast<long long>(copyRows(snapshot, store))) });
+    }
+
+    // The live store's footprint; only a CompressedStore has one to report.
+    void compressStats(CommandResult& r) {
+        const CompressedStore* compressed = dynamic_cast<const CompressedStore*>(&store);
+        if (!compressed) return fail(r, "compress-stats needs --store compressed or the tree");
+        r.columns = COMPRESSION_COLUMNS;
+        r.rows.push_back(compressionRow(compressed->stats()));
+    }
+
+public:
+    explicit HistoryExecutor(HistoryStore& store) : store(store) {}
+
+    // Commands that only read rows, so a read-only store can serve them.
+    static bool readsRows(const std::string& verb) {
+        return verb == "search" || verb == "ticker" || verb == "range" || verb == "range-stats" ||
+               verb == "metrics" || verb == "trade" || verb == "export" || verb == "dump-metrics";
+    }
+
+    void execute(const BatchCommand& cmd, CommandResult& r) {
+        Clock::time_point start = Clock::now();
+        const std::string& verb = cmd.args[0];
+        size_t argc = cmd.args.size() - 1;
+        if (verb == "search" && argc == 2) search(cmd, r);
+        else if (verb == "ticker" && argc == 1) rows(store.getStocksByTicker(cmd.args[1]), r);
+        else if (verb == "range" && argc == 3) rows(store.getStocksByDateRange(cmd.args[1], cmd.args[2], cmd.args[3]), r);
+        else if (verb == "range-stats" && argc == 3) rangeStats(cmd, r);
+        else if (verb == "metrics" && argc == 1) metrics(cmd, r);
+        else if (verb == "trade" && argc == 4) trade(cmd, r);
+        else if (verb == "export" && argc >= 1 && argc <= 4) exportRows(cmd, r);
+        else if (verb == "dump-metrics" && (argc == 1 || argc == 2)) writeMetrics(cmd, nullptr, r);
+        else if (verb == "import-csv" && argc == 1) importCsv(cmd, r);
+        else if (verb == "load-snapshot" && argc == 1) loadSnapshot(cmd, r);
+        else if (verb == "compress-stats" && argc == 0) compressStats(r);
+        else if (verb == "resample" || verb == "backtest" || verb == "correlate" ||
+                 verb == "screen" || verb == "import-api" || verb == "sync")
+            fail(r, verb + " needs the tree; run without --store");
+        else fail(r, "unknown command or wrong number of arguments");
+        r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+};
+
+void writeCsvField(std::ostream& out, const std::string& s) {
+    if (s.find_first_of(",\"\n") == std::string::npos) {
+        out << s;
+        return;
+    }
+    out << '"';
+    for (char ch : s) {
+        if (ch == '"') out << '"';
+        out << ch;
+    }
+    out << '"';
+}
+
+void writeJsonString(std::ostream& out, const std::string& s) {
+    out << '"';
+    for (unsigned char ch : s) {
+        if (ch == '"' || ch == '\\') out << '\\' << ch;
+        else if (ch < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", ch);
+            out << buf;
+        }
+        else out << ch;
+    }
+    out << '"';
+}
+
+void writeResult(std::ostream& out, BatchFormat format, const BatchCommand& cmd, const CommandResult& r) {
+    if (format == BatchFormat::Csv) {
+        out << "# " << cmd.index << ' ' << cmd.text << '\n';
+        if (!r.ok) {
+            out << "# error: " << r.error << '\n';
+            return;
+        }
+        for (size_t i = 0; i < r.columns.size(); i++) out << (i ? "," : "") << r.columns[i];
+        out << '\n';
+        for (const auto& row : r.rows) {
+            for (size_t i = 0; i < row.size(); i++) {
+                if (i) out << ',';
+                writeCsvField(out, row[i].text);
+            }
+            out << '\n';
+        }
+        return;
+    }
+
+    out << "{\"query\":" << cmd.index << ",\"command\":";
+    writeJsonString(out, cmd.text);
+    char latency[32];
+    std::snprintf(latency, sizeof(latency), "%.3f", r.seconds * 1e6);
+    out << ",\"ok\":" << (r.ok ? "true" : "false") << ",\"latency_us\":" << latency;
+    if (!r.ok) {
+        out << ",\"error\":";
+        writeJsonString(out, r.error);
+    }
+    else {
+        out << ",\"rows\":[";
+        for (size_t k = 0; k < r.rows.size(); k++) {
+            out << (k ? ",{" : "{");
+            for (size_t i = 0; i < r.columns.size(); i++) {
+                if (i) out << ',';
+                writeJsonString(out, r.columns[i]);
+                out << ':';
+                if (r.rows[k][i].number) out << r.rows[k][i].text;
+                else writeJsonString(out, r.rows[k][i].text);
+            }
+            out << '}';
+        }
+        out << ']';
+    }
+    out << "}\n";
+}
+
+bool parseCommand(const std::string& line, size_t index, BatchCommand& cmd) {
+    size_t begin = line.find_first_not_of(" \t\r");
+    if (begin == std::string::npos || line[begin] == '#') return false;
+    size_t end = line.find_last_not_of(" \t\r");
+    cmd.index = index;
+    cmd.text = line.substr(begin, end - begin + 1);
+    cmd.args.clear();
+    std::stringstream ss(cmd.text);
+    std::string token;
+    while (ss >> token) cmd.args.push_back(token);
+    return true;
+}
+
+} // namespace
+
+double BatchStats::percentile(double p) const {
+    if (latencies.empty()) return 0;
+    std::vector<double> sorted = latencies;
+    size_t rank = static_cast<size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+    rank = std::min(rank, sorted.size() - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+bool runBatch(AVLTree& tree, std::istream& script, std::ostream& out,
+              const BatchOptions& options, BatchStats& stats) {
+    BatchExecutor executor(tree, options);
+    std::unique_ptr<HistoryExecutor> history;
+    if (options.store) {
+        history.reset(new HistoryExecutor(*options.store));
+        if (options.snapshot) copyRows(*options.snapshot, *options.store);
+    } else if (options.snapshot) {
+        history.reset(new HistoryExecutor(*options.snapshot));
+    }
+    // Reads are served from the mapped snapshot; the first command that
+    // needs the tree builds it once and later commands use it.
+    bool mapped = options.snapshot && !options.store;
+    auto execute = [&](const BatchCommand& cmd, CommandResult& r) {
+        if (history) history->execute(cmd, r);
+        else executor.execute(cmd, r);
+    };
+    ThreadPool& pool = ThreadPool::shared();
+    std::vector<BatchCommand> group;
+    std::vector<CommandResult> results;
+    Clock::time_point start = Clock::now();
+
+    auto record = [&](const BatchCommand& cmd, const CommandResult& r) {
+        writeResult(out, options.format, cmd, r);
+        stats.commands++;
+        if (!r.ok) stats.failed++;
+        stats.latencies.push_back(r.seconds);
+    };
+
+    // Read-only commands share the tree without locking; results are
+    // buffered so they come out in script order.
+    auto runGroup = [&]() {
+        if (group.empty()) return;
+        results.assign(group.size(), CommandResult());
+        pool.parallelFor(group.size(), [&](size_t i) { execute(group[i], results[i]); });
+        for (size_t i = 0; i < group.size(); i++) record(group[i], results[i]);
+        out.flush();
+        group.clear();
+    };
+
+    std::string line;
+    size_t lineNumber = 0;
+    BatchCommand cmd;
+    while (std::getline(script, line)) {
+        if (!parseCommand(line, ++lineNumber, cmd)) continue;
+        if (mapped && !HistoryExecutor::readsRows(cmd.args[0])) {
+            runGroup();
+            options.snapshot->loadInto(tree);
+            history.reset();
+            mapped = false;
+        }
+        if (!mutates(cmd.args[0]) && !writesFile(cmd.args[0])) {
+            group.push_back(cmd);
+            if (group.size() >= options.groupLimit) runGroup();
+            continue;
+        }
+        runGroup();
+        CommandResult r;
+        execute(cmd, r);
+        record(cmd, r);
+        out.flush();
+    }
+    runGroup();
+
+    stats.wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return stats.failed == 0;
+}
+
+void printBatchStats(const BatchStats& stats, std::ostream& out) {
+    char buf[256];
+    std::snprintf(buf, sizeof(buf),
+                  "%zu commands (%zu failed) in %.3f s, %.1f commands/s; latency p50 %.1f us, "
+                  "p95 %.1f us, p99 %.1f us, max %.1f us\n",
+                  stats.commands, stats.failed, stats.wallSeconds,
+                  stats.wallSeconds > 0 ? stats.commands / stats.wallSeconds : 0.0,
+                  stats.percentile(50) * 1e6, stats.percentile(95) * 1e6,
+                  stats.percentile(99) * 1e6, stats.percentile(100) * 1e6);
+    out << buf;
+}
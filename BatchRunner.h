@@ -0,0 +1,68 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include "AVLTree.h"
+#include "HistoryStore.h"
+#include "ImportStockData.h"
+#include "Snapshot.h"
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+enum class BatchFormat { Csv, Json };
+
+struct BatchOptions {
+    BatchFormat format = BatchFormat::Csv;
+    size_t groupLimit = 4096;                   // read-only commands run per parallel group
+    const ApiImportConfig* api = nullptr;       // null disables import-api and sync
+    HistoryStore* store = nullptr;              // set: run against this instead of the tree
+    Snapshot* snapshot = nullptr;               // opened snapshot to start from
+};
+
+struct BatchStats {
+    size_t commands = 0;
+    size_t failed = 0;
+    double wallSeconds = 0;
+    std::vector<double> latencies;              // seconds per command, in script order
+
+    double percentile(double p) const;          // p in [0, 100]
+};
+
+// Headless command mode. Reads one command per line (blank lines and
+// lines starting with '#' are skipped):
+//
+//   import-csv FILE                  import-api T1,T2,...    sync [T1,T2,...]
+//   load-snapshot FILE               search TICKER DATE      ticker TICKER
+//   range TICKER START END           metrics TICKER
+//   range-stats TICKER START END     resample TICKER week|month|Nd [START|*] [END|*]
+//   trade TICKER DATE B|S QUANTITY   export FILE [TICKERS|*] [START|*] [END|*]
+//   backtest sma FASTS SLOWS [TICKERS|*]
+//   backtest breakout LOOKBACKS WIDTHS [TICKERS|*]
+//   correlate TICKERS|* [START|*] [END|*]   compress-stats
+//   screen return|change|volatility|volume top|bottom K [START|*] [END|*] [MIN_AVG_VOLUME]
+//   dump-metrics FILE [json|prometheus]
+//
+// Consecutive read-only commands (everything but the imports, sync,
+// load-snapshot and the file writers export and dump-metrics) run in
+// parallel on the shared thread pool; any other command waits for them
+// and runs alone. Results are written in script
+// order: CSV as "# N command" followed by a header and rows per command,
+// JSON as one object per line. Returns false if any command failed.
+//
+// With options.store set the tree is left alone and the row commands
+// (import-csv, load-snapshot, search, ticker, range, range-stats,
+// metrics, trade, export, dump-metrics, and compress-stats on a
+// CompressedStore) run against the store; the others fail with an error
+// naming the command.
+//
+// With options.snapshot set, its rows are copied into the store up front;
+// without a store, row commands read the mapped file directly and the
+// tree is only built, once, when the first other command arrives.
+bool runBatch(AVLTree& tree, std::istream& script, std::ostream& out,
+              const BatchOptions& options, BatchStats& stats);
+
+// Query count, wall time, throughput and latency percentiles.
+void printBatchStats(const BatchStats& stats, std::ostream& out);
+
+#endif
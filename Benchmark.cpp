@@ -0,0 +1,362 @@
+#include "Benchmark.h"
+#include "CompressedStore.h"
+#include "Correlation.h"
+#include "CsvExporter.h"
+#include "CsvLoader.h"
+#include "Screener.h"
+#include "DateUtils.h"
+#include "FinancialMetrics.h"
+#include "SimdKernels.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+struct BenchResult {
+    std::string name;
+    size_t ops;
+    double seconds;
+    double checksum;
+};
+
+class BenchReport {
+private:
+    std::vector<BenchResult> results;
+
+public:
+    CompressionStats compression;
+    void add(const std::string& name, size_t ops, double seconds, double checksum) {
+        results.push_back({name, ops, seconds, checksum});
+        // Progress goes to stderr so the JSON on `out` stays clean.
+        std::cerr << "[bench] " << name << ": " << ops << " ops in " << seconds << " s\n";
+    }
+
+    void write(std::ostream& out, const BenchConfig& config, const SyntheticMarket& market,
+               const SlabStats& memory, size_t treeRows) const {
+        char buf[256];
+        out << "{\n  \"suite\": \"market-metrics\",\n";
+        out << "  \"config\": {\"tickers\": " << market.tickerCount() << ", \"days\": " << market.dayCount()
+            << ", \"rows\": " << market.rowCount() << ", \"seed\": " << config.data.seed
+            << ", \"queries\": " << config.queries << ", \"chunk_rows\": " << config.chunkRows
+            << ", \"simd\": \"" << SimdKernels::levelName(SimdKernels::activeLevel())
+            << "\", \"threads\": " << ThreadPool::shared().size() << "},\n";
+        std::snprintf(buf, sizeof(buf),
+                      "  \"memory\": {\"node_bytes\": %zu, \"slabs\": %zu, \"bytes_reserved\": %zu, "
+                      "\"bytes_per_row\": %.2f},\n",
+                      memory.blockSize, memory.slabs, memory.bytesReserved,
+                      treeRows ? static_cast<double>(memory.bytesReserved) / treeRows : 0.0);
+        out << buf;
+        std::snprintf(buf, sizeof(buf),
+                      "  \"compressed\": {\"rows\": %zu, \"blocks\": %zu, \"bytes_stored\": %zu, "
+                      "\"bytes_per_row\": %.2f, \"ratio\": %.2f},\n",
+                      compression.rows, compression.blocks, compression.storedBytes,
+                      compression.bytesPerRow(), compression.ratio());
+        out << buf;
+        out << "  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const BenchResult& r = results[i];
+            double perSec = r.seconds > 0 ? r.ops / r.seconds : 0;
+            double nsPerOp = r.ops > 0 ? r.seconds * 1e9 / r.ops : 0;
+            std::snprintf(buf, sizeof(buf),
+                          "    {\"name\": \"%s\", \"ops\": %zu, \"seconds\": %.6f, \"ops_per_sec\": %.1f, "
+                          "\"ns_per_op\": %.2f, \"checksum\": %.17g}%s\n",
+                          r.name.c_str(), r.ops, r.seconds, perSec, nsPerOp, r.checksum,
+                          i + 1 < results.size() ? "," : "");
+            out << buf;
+        }
+        out << "  ]\n}\n";
+    }
+};
+
+// Hands the market to `fn` in chunks of whole tickers, roughly chunkRows
+// rows at a time, and returns the time spent generating.
+template <typename Fn>
+double forEachChunk(const SyntheticMarket& market, size_t chunkRows, Fn fn) {
+    size_t perChunk = std::max<size_t>(1, chunkRows / std::max<size_t>(1, market.dayCount()));
+    std::vector<StockData> rows;
+    double generating = 0;
+    for (size_t first = 0; first < market.tickerCount(); first += perChunk) {
+        rows.clear();
+        Clock::time_point start = Clock::now();
+        market.generate(first, perChunk, rows);
+        generating += secondsSince(start);
+        fn(rows);
+    }
+    return generating;
+}
+
+void benchMetrics(const AVLTree& tree, const SyntheticMarket& market, BenchReport& report) {
+    enum { SMA_ROWS, EMA_ROWS, VOL_ROWS, SMA_COL, EMA_COL, VOL_COL, RETURNS, LOG_RETURNS,
+           PRICE_CHANGE, PCT_RETURN, METRIC_COUNT };
+    static const char* names[METRIC_COUNT] = {
+        "metrics.sma.rows", "metrics.ema.rows", "metrics.volatility.rows",
+        "metrics.sma.column", "metrics.ema.column", "metrics.volatility.column",
+        "metrics.returns", "metrics.log_returns", "metrics.daily_price_change", "metrics.percentage_return"
+    };
+    double seconds[METRIC_COUNT] = {};
+    double checksum[METRIC_COUNT] = {};
+    size_t rows = 0;
+
+    std::vector<double> closes;
+    for (size_t t = 0; t < market.tickerCount(); t++) {
+        std::string name = market.tickerName(t);
+        std::vector<StockData> stocks = tree.getStocksByTicker(name);
+        closes.clear();
+        for (const auto& s : stocks) closes.push_back(s.closePrice);
+        rows += stocks.size();
+
+        Clock::time_point start = Clock::now();
+        checksum[SMA_ROWS] += FinancialMetrics::calculateSMA(stocks, 20);
+        seconds[SMA_ROWS] += secondsSince(start);
+        start = Clock::now();
+        checksum[EMA_ROWS] += FinancialMetrics::calculateEMA(stocks, 50);
+        seconds[EMA_ROWS] += secondsSince(start);
+        start = Clock::now();
+        checksum[VOL_ROWS] += FinancialMetrics::calculateVolatility(stocks);
+        seconds[VOL_ROWS] += secondsSince(start);
+        start = Clock::now();
+        checksum[SMA_COL] += FinancialMetrics::calculateSMA(closes, 20);
+        seconds[SMA_COL] += secondsSince(start);
+        start = Clock::now();
+        checksum[EMA_COL] += FinancialMetrics::calculateEMA(closes, 50);
+        seconds[EMA_COL] += secondsSince(start);
+        start = Clock::now();
+        checksum[VOL_COL] += FinancialMetrics::calculateVolatility(closes);
+        seconds[VOL_COL] += secondsSince(start);
+        start = Clock::now();
+        std::vector<double> returns = FinancialMetrics::calculateReturns(closes.data(), closes.size());
+        seconds[RETURNS] += secondsSince(start);
+        if (!returns.empty()) checksum[RETURNS] += returns.back();
+        start = Clock::now();
+        std::vector<double> logReturns = FinancialMetrics::calculateLogReturns(closes.data(), closes.size());
+        seconds[LOG_RETURNS] += secondsSince(start);
+        if (!logReturns.empty()) checksum[LOG_RETURNS] += logReturns.back();
+
+        start = Clock::now();
+        double change = 0;
+        for (const auto& s : stocks) change += FinancialMetrics::dailyPriceChange(s.openPrice, s.closePrice);
+        seconds[PRICE_CHANGE] += secondsSince(start);
+        checksum[PRICE_CHANGE] += change;
+        start = Clock::now();
+        double pct = 0;
+        for (size_t i = 1; i < closes.size(); i++) pct += FinancialMetrics::percentageReturn(closes[i - 1], closes[i]);
+        seconds[PCT_RETURN] += secondsSince(start);
+        checksum[PCT_RETURN] += pct;
+    }
+    for (int m = 0; m < METRIC_COUNT; m++) report.add(names[m], rows, seconds[m], checksum[m]);
+}
+
+// A year of daily returns across up to 3,000 tickers, the size of a risk run.
+void benchCorrelation(const AVLTree& tree, const SyntheticMarket& market, BenchReport& report) {
+    std::vector<std::string> tickers;
+    for (size_t t = 0; t < std::min<size_t>(market.tickerCount(), 3000); t++) tickers.push_back(market.tickerName(t));
+    size_t days = market.dayCount();
+    int startDay = market.day(days > 253 ? days - 253 : 0);
+    CorrelationMatrix matrix;
+    std::string error;
+    Clock::time_point start = Clock::now();
+    if (!matrix.build(tree, tickers, startDay, market.day(days - 1), ThreadPool::shared(), error)) return;
+    double seconds = secondsSince(start);
+    double checksum = 0;
+    for (size_t i = 0; i < matrix.size(); i++)
+        for (size_t j = i + 1; j < matrix.size(); j++) checksum += matrix.correlation(i, j);
+    report.add("correlation_matrix", matrix.size() * (matrix.size() - 1) / 2, seconds, checksum);
+}
+
+// The same history in compressed blocks: load, then SMA(20) over every
+// ticker's closes decoded on the fly.
+void benchCompressed(const AVLTree& tree, const SyntheticMarket& market, BenchReport& report) {
+    CompressedStore store;
+    Clock::time_point start = Clock::now();
+    store.loadFrom(tree);
+    report.add("compressed_load", store.size(), secondsSince(start), static_cast<double>(store.size()));
+    report.compression = store.stats();
+
+    double checksum = 0;
+    start = Clock::now();
+    for (size_t t = 0; t < market.tickerCount(); t++) {
+        std::vector<double> closes = store.closes(market.tickerName(t), INT_MIN, INT_MAX);
+        checksum += FinancialMetrics::calculateSMA(closes, 20);
+    }
+    report.add("compressed_metrics", store.size(), secondsSince(start), checksum);
+}
+
+// The morning screen: top 20 movers over the last year of data, whole universe.
+void benchScreen(const AVLTree& tree, const SyntheticMarket& market, BenchReport& report) {
+    ScreenQuery query;
+    size_t days = market.dayCount();
+    query.startDay = market.day(days > 253 ? days - 253 : 0);
+    query.minAverageVolume = 1;
+    Clock::time_point start = Clock::now();
+    std::vector<ScreenResult> results = runScreen(tree, query, ThreadPool::shared());
+    double seconds = secondsSince(start);
+    double checksum = 0;
+    for (const ScreenResult& r : results) checksum += r.value;
+    report.add("screen_top_movers", market.tickerCount(), seconds, checksum);
+}
+
+bool parseCount(const char* text, size_t& value) {
+    char* end;
+    unsigned long long parsed = std::strtoull(text, &end, 10);
+    if (end == text || *end != '\0') return false;
+    value = static_cast<size_t>(parsed);
+    return true;
+}
+
+} // namespace
+
+bool runBenchmarks(const BenchConfig& config, std::ostream& out, std::string& error) {
+    if (config.data.tickers == 0 || config.data.days == 0) {
+        error = "need at least one ticker and one day";
+        return false;
+    }
+    SyntheticMarket market(config.data);
+    BenchReport report;
+    std::mt19937_64 rng(config.data.seed);
+
+    // Inserts first, in their own tree, so the bulk-loaded tree below is
+    // the only one alive for the query benchmarks.
+    double generating = 0;
+    if (!config.skipInsert) {
+        AVLTree tree;
+        double seconds = 0;
+        generating = forEachChunk(market, config.chunkRows, [&](const std::vector<StockData>& rows) {
+            Clock::time_point start = Clock::now();
+            for (const auto& row : rows) tree.insert(row);
+            seconds += secondsSince(start);
+        });
+        report.add("insert", market.rowCount(), seconds, static_cast<double>(tree.size()));
+    }
+
+    AVLTree tree;
+    double loading = 0;
+    double generated = forEachChunk(market, config.chunkRows, [&](const std::vector<StockData>& rows) {
+        Clock::time_point start = Clock::now();
+        tree.bulkLoad(rows);
+        loading += secondsSince(start);
+    });
+    if (config.skipInsert) generating = generated;
+    report.add("generate", market.rowCount(), generating, 0);
+    report.add("bulk_load", market.rowCount(), loading, static_cast<double>(tree.size()));
+
+    // Point searches on rows known to exist, through the string API.
+    {
+        std::vector<std::pair<std::string, std::string>> queries;
+        queries.reserve(config.queries);
+        for (size_t q = 0; q < config.queries; q++) {
+            queries.emplace_back(market.tickerName(rng() % market.tickerCount()),
+                                 DateUtils::toDateString(market.day(rng() % market.dayCount())));
+        }
+        StockData found;
+        double checksum = 0;
+        Clock::time_point start = Clock::now();
+        for (const auto& q : queries)
+            if (tree.search(q.first, q.second, found)) checksum += found.closePrice;
+        report.add("search", queries.size(), secondsSince(start), checksum);
+    }
+
+    {
+        std::vector<std::string> tickers = tree.getTickers();
+        double checksum = 0;
+        size_t visited = 0;
+        Clock::time_point start = Clock::now();
+        for (const auto& ticker : tickers) {
+            for (RangeCursor c = tree.scanTicker(ticker); c.valid(); c.next()) {
+                checksum += c->closePrice;
+                visited++;
+            }
+        }
+        report.add("scan_ticker", visited, secondsSince(start), checksum);
+    }
+
+    // One trading month per range.
+    {
+        const size_t span = std::min<size_t>(21, market.dayCount());
+        struct Range { std::string ticker, startDate, endDate; };
+        std::vector<Range> ranges;
+        for (size_t q = 0; q < std::max<size_t>(1, config.queries / 10); q++) {
+            size_t t = rng() % market.tickerCount();
+            size_t first = rng() % (market.dayCount() - span + 1);
+            ranges.push_back({market.tickerName(t), DateUtils::toDateString(market.day(first)),
+                              DateUtils::toDateString(market.day(first + span - 1))});
+        }
+        double checksum = 0;
+        Clock::time_point start = Clock::now();
+        for (const auto& r : ranges) {
+            for (RangeCursor c = tree.scanDateRange(r.ticker, r.startDate, r.endDate); c.valid(); c.next())
+                checksum += c->closePrice;
+        }
+        report.add("scan_range", ranges.size(), secondsSince(start), checksum);
+    }
+
+    if (!config.skipCsv) {
+        std::string path = config.scratchDir + "/market_metrics_bench.csv";
+        size_t written = 0;
+        Clock::time_point start = Clock::now();
+        if (!CsvExporter::exportFile(tree, path, CsvExportFilter(), written)) {
+            error = "cannot write " + path;
+            return false;
+        }
+        report.add("csv_export", written, secondsSince(start), static_cast<double>(written));
+
+        AVLTree imported;
+        CsvLoadResult result;
+        start = Clock::now();
+        bool loaded = CsvLoader::importFile(imported, path, result);
+        double seconds = secondsSince(start);
+        std::remove(path.c_str());
+        if (!loaded) {
+            error = "cannot read back " + path;
+            return false;
+        }
+        report.add("csv_import", result.rows.size(), seconds, static_cast<double>(imported.size()));
+    }
+
+    benchMetrics(tree, market, report);
+    benchCorrelation(tree, market, report);
+    benchCompressed(tree, market, report);
+    benchScreen(tree, market, report);
+
+    report.write(out, config, market, tree.memoryStats(), tree.size());
+    return true;
+}
+
+bool parseBenchArgs(int argc, char* argv[], BenchConfig& config, std::string& outPath, std::string& error) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--bench") continue;
+        if (arg == "--skip-insert") { config.skipInsert = true; continue; }
+        if (arg == "--skip-csv") { config.skipCsv = true; continue; }
+        if (i + 1 >= argc) {
+            error = "missing value for " + arg;
+            return false;
+        }
+        const char* value = argv[++i];
+        size_t n = 0;
+        bool numeric = parseCount(value, n);
+        if (arg == "--tickers" && numeric) config.data.tickers = n;
+        else if (arg == "--days" && numeric) config.data.days = n;
+        else if (arg == "--seed" && numeric) config.data.seed = n;
+        else if (arg == "--queries" && numeric) config.queries = n;
+        else if (arg == "--chunk-rows" && numeric && n > 0) config.chunkRows = n;
+        else if (arg == "--scratch") config.scratchDir = value;
+        else if (arg == "--out") outPath = value;
+        else {
+            error = "bad option " + arg + " " + value;
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,27 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "SyntheticData.h"
+#include <ostream>
+#include <string>
+
+struct BenchConfig {
+    SyntheticConfig data;
+    size_t queries = 1000000;       // point searches; range scans use a tenth
+    size_t chunkRows = 1 << 20;     // rows generated and loaded per step
+    std::string scratchDir = ".";   // where the CSV round trip is written
+    bool skipInsert = false;        // per-row inserts dominate at 100M rows
+    bool skipCsv = false;
+};
+
+// Runs the suite over a synthetic market and writes one JSON document to
+// `out`: the configuration, then {name, ops, seconds, ops_per_sec,
+// ns_per_op, checksum} per benchmark. Checksums are deterministic for a
+// given configuration, so two runs can be compared row by row and a
+// result that drifts points at a behavior change, not just a speed one.
+bool runBenchmarks(const BenchConfig& config, std::ostream& out, std::string& error);
+
+// Parses "--bench" command-line options; returns false on a bad option.
+bool parseBenchArgs(int argc, char* argv[], BenchConfig& config, std::string& outPath, std::string& error);
+
+#endif
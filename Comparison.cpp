@@ -0,0 +1,34 @@
+#include "Comparison.h"
+#include "FinancialMetrics.h"
+
+namespace {
+    void compareOne(const AVLTree& tree, const Indicators::IndicatorConfig& config, TickerComparison& out) {
+        Indicators::IndicatorStream stream(config);
+        std::vector<double> closes;
+        double ema = 0;
+        for (RangeCursor c = tree.scanTicker(out.ticker); c.valid(); c.next()) {
+            Indicators::IndicatorPoint p = stream.push(c->closePrice);
+            ComparisonRow row = { keyDay(c.key()), c->closePrice, p.sma, p.stddev };
+            out.rows.push_back(row);
+            closes.push_back(c->closePrice);
+            if (Indicators::hasValue(p.ema)) ema = p.ema;
+        }
+        out.ema = ema;
+        out.volatility = FinancialMetrics::calculateVolatility(closes);
+        out.periodReturn = closes.size() > 1
+            ? FinancialMetrics::percentageReturn(closes.front(), closes.back())
+            : 0;
+    }
+}
+
+std::vector<TickerComparison> compareTickers(const AVLTree& tree,
+                                             const std::vector<std::string>& tickers,
+                                             const Indicators::IndicatorConfig& config,
+                                             ThreadPool& pool) {
+    std::vector<TickerComparison> results(tickers.size());
+    pool.parallelFor(tickers.size(), [&](size_t i) {
+        results[i].ticker = tickers[i];
+        compareOne(tree, config, results[i]);
+    });
+    return results;
+}
@@ -0,0 +1,33 @@
+#ifndef COMPARISON_H
+#define COMPARISON_H
+
+#include "AVLTree.h"
+#include "Indicators.h"
+#include "ThreadPool.h"
+#include <string>
+#include <vector>
+
+struct ComparisonRow {
+    int day;                // days since 1970-01-01
+    double close;
+    double sma;             // rolling, Indicators::NO_VALUE until warmed up
+    double volatility;      // rolling population std dev
+};
+
+struct TickerComparison {
+    std::string ticker;
+    std::vector<ComparisonRow> rows;
+    double ema;             // over the whole series
+    double volatility;      // over the whole series
+    double periodReturn;    // first to last close, percent
+};
+
+// Computes every ticker's comparison independently on the pool, one task
+// per ticker, and returns results in the order the tickers were given.
+// The tree must not be mutated while this runs.
+std::vector<TickerComparison> compareTickers(const AVLTree& tree,
+                                             const std::vector<std::string>& tickers,
+                                             const Indicators::IndicatorConfig& config,
+                                             ThreadPool& pool);
+
+#endif
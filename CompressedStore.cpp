@@ -0,0 +1,508 @@
+#include "CompressedStore.h"
+#include "DateUtils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    const size_t RAW_ROW_BYTES = sizeof(int32_t) + 4 * sizeof(double) + sizeof(int64_t);
+
+    uint64_t bitsOf(double v) {
+        uint64_t b;
+        memcpy(&b, &v, sizeof(b));
+        return b;
+    }
+
+    double fromBits(uint64_t b) {
+        double v;
+        memcpy(&v, &b, sizeof(v));
+        return v;
+    }
+
+    int leadingZeros(uint64_t x) {      // x != 0
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_clzll(x);
+#else
+        int n = 0;
+        while (!(x & (1ull << 63))) { x <<= 1; n++; }
+        return n;
+#endif
+    }
+
+    int trailingZeros(uint64_t x) {     // x != 0
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(x);
+#else
+        int n = 0;
+        while (!(x & 1)) { x >>= 1; n++; }
+        return n;
+#endif
+    }
+
+    uint64_t zigzag(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+    int64_t unzigzag(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+    void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+        while (v >= 0x80) {
+            out.push_back(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(v));
+    }
+
+    uint64_t getVarint(const uint8_t*& p) {
+        uint64_t v = 0;
+        int shift = 0;
+        while (*p & 0x80) {
+            v |= static_cast<uint64_t>(*p++ & 0x7F) << shift;
+            shift += 7;
+        }
+        return v | static_cast<uint64_t>(*p++) << shift;
+    }
+
+    // MSB-first bit stream appended to a byte buffer; starts on a fresh byte.
+    class BitWriter {
+    private:
+        std::vector<uint8_t>& out;
+        int used;                   // bits filled in out.back()
+
+    public:
+        explicit BitWriter(std::vector<uint8_t>& out) : out(out), used(0) {}
+        void write(uint64_t value, int bits) {
+            while (bits > 0) {
+                int take = std::min(bits, 8 - used);
+                uint8_t chunk = static_cast<uint8_t>((value >> (bits - take)) & ((1u << take) - 1));
+                if (used == 0) out.push_back(0);
+                out.back() |= static_cast<uint8_t>(chunk << (8 - used - take));
+                used = (used + take) % 8;
+                bits -= take;
+            }
+        }
+    };
+
+    class BitReader {
+    private:
+        const uint8_t* data;
+        size_t pos;                 // in bits
+
+    public:
+        explicit BitReader(const uint8_t* data) : data(data), pos(0) {}
+        uint64_t read(int bits) {
+            uint64_t v = 0;
+            while (bits > 0) {
+                int offset = static_cast<int>(pos & 7);
+                int take = std::min(bits, 8 - offset);
+                v = (v << take) | ((data[pos >> 3] >> (8 - offset - take)) & ((1u << take) - 1));
+                pos += take;
+                bits -= take;
+            }
+            return v;
+        }
+    };
+
+    // Gorilla: the first value verbatim, then per value a '0' bit when it
+    // repeats, '10' + the meaningful bits when the XOR fits the previous
+    // leading/trailing-zero window, or '11' + 5-bit leading zeros + 6-bit
+    // length + the meaningful bits.
+    void xorEncode(BitWriter& w, const double* v, size_t n) {
+        uint64_t prev = bitsOf(v[0]);
+        w.write(prev, 64);
+        int lead = -1, trail = 0;
+        for (size_t i = 1; i < n; i++) {
+            uint64_t cur = bitsOf(v[i]);
+            uint64_t x = cur ^ prev;
+            prev = cur;
+            if (x == 0) {
+                w.write(0, 1);
+                continue;
+            }
+            int lz = std::min(leadingZeros(x), 31), tz = trailingZeros(x);
+            if (lead >= 0 && lz >= lead && tz >= trail) {
+                w.write(2, 2);
+                w.write(x >> trail, 64 - lead - trail);
+            } else {
+                lead = lz;
+                trail = tz;
+                int length = 64 - lz - tz;
+                w.write(3, 2);
+                w.write(static_cast<uint64_t>(lz), 5);
+                w.write(static_cast<uint64_t>(length & 63), 6);     // 64 is written as 0
+                w.write(x >> tz, length);
+            }
+        }
+    }
+
+    void xorDecode(BitReader& r, double* v, size_t n) {
+        uint64_t prev = r.read(64);
+        v[0] = fromBits(prev);
+        int lead = 0, trail = 0;
+        for (size_t i = 1; i < n; i++) {
+            if (r.read(1)) {
+                if (r.read(1)) {
+                    lead = static_cast<int>(r.read(5));
+                    int length = static_cast<int>(r.read(6));
+                    if (length == 0) length = 64;
+                    trail = 64 - lead - length;
+                }
+                prev ^= r.read(64 - lead - trail) << trail;
+            }
+            v[i] = fromBits(prev);
+        }
+    }
+
+    const double SCALES[] = { 1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6 };
+    const uint8_t MAX_DIGITS = 6;
+
+    // The first of 2, 4 or 6 decimal digits at which every price
+    // round-trips exactly through an integer, or XOR_PRICES. Fills
+    // `fixed` (close, open, high, low per row).
+    uint8_t fixedPointDigits(const TickerSeries& rows, size_t first, size_t last, std::vector<int64_t>& fixed) {
+        const std::vector<double>* columns[4] = { &rows.close, &rows.open, &rows.high, &rows.low };
+        for (uint8_t digits = 2; digits <= MAX_DIGITS; digits += 2) {
+            const double scale = SCALES[digits];
+            fixed.clear();
+            bool exact = true;
+            for (size_t i = first; i < last && exact; i++) {
+                for (const std::vector<double>* column : columns) {
+                    double p = (*column)[i];
+                    double scaled = p * scale;
+                    if (!(std::fabs(scaled) < 4503599627370496.0)) {    // 2^52, also rejects NaN
+                        exact = false;
+                        break;
+                    }
+                    int64_t q = std::llround(scaled);
+                    if (bitsOf(static_cast<double>(q) / scale) != bitsOf(p)) {
+                        exact = false;
+                        break;
+                    }
+                    fixed.push_back(q);
+                }
+            }
+            if (exact) return digits;
+        }
+        return HistoryBlock::XOR_PRICES;
+    }
+}
+
+HistoryBlock HistoryBlock::encode(const TickerSeries& rows, size_t first, size_t last) {
+    HistoryBlock b;
+    const size_t n = last - first;
+    b.count = static_cast<uint32_t>(n);
+    b.firstDay = rows.dates[first];
+    b.lastDay = rows.dates[last - 1];
+    std::vector<uint8_t>& out = b.bytes;
+
+    for (size_t i = first + 1; i < last; i++)
+        putVarint(out, static_cast<uint64_t>(rows.dates[i] - rows.dates[i - 1]));
+
+    std::vector<int64_t> fixed;
+    b.priceDigits = fixedPointDigits(rows, first, last, fixed);
+    b.closeOffset = static_cast<uint32_t>(out.size());
+    if (b.priceDigits != XOR_PRICES) {
+        int64_t previous = 0;
+        for (size_t i = 0; i < n; i++) {
+            putVarint(out, zigzag(fixed[4 * i] - previous));
+            previous = fixed[4 * i];
+        }
+        b.otherOffset = static_cast<uint32_t>(out.size());
+        for (size_t i = 0; i < n; i++)
+            for (int k = 1; k < 4; k++) putVarint(out, zigzag(fixed[4 * i + k] - fixed[4 * i]));
+    } else {
+        BitWriter closes(out);
+        xorEncode(closes, &rows.close[first], n);
+        b.otherOffset = static_cast<uint32_t>(out.size());
+        BitWriter others(out);
+        xorEncode(others, &rows.open[first], n);
+        xorEncode(others, &rows.high[first], n);
+        xorEncode(others, &rows.low[first], n);
+    }
+
+    b.volumeOffset = static_cast<uint32_t>(out.size());
+    for (size_t i = first; i < last; i++) putVarint(out, zigzag(rows.volume[i]));
+    out.shrink_to_fit();
+    return b;
+}
+
+void HistoryBlock::decode(TickerSeries& out, bool closesOnly) const {
+    const uint8_t* data = bytes.data();
+    out.dates.resize(count);
+    out.close.resize(count);
+    out.open.resize(closesOnly ? 0 : count);
+    out.high.resize(closesOnly ? 0 : count);
+    out.low.resize(closesOnly ? 0 : count);
+    out.volume.resize(closesOnly ? 0 : count);
+
+    const uint8_t* p = data;
+    out.dates[0] = firstDay;
+    for (uint32_t i = 1; i < count; i++) out.dates[i] = out.dates[i - 1] + static_cast<int>(getVarint(p));
+
+    if (priceDigits != XOR_PRICES) {
+        const double scale = SCALES[priceDigits];
+        p = data + closeOffset;
+        std::vector<int64_t> closes(count);
+        int64_t previous = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            previous += unzigzag(getVarint(p));
+            closes[i] = previous;
+            out.close[i] = static_cast<double>(previous) / scale;
+        }
+        if (!closesOnly) {
+            p = data + otherOffset;
+            for (uint32_t i = 0; i < count; i++) {
+                out.open[i] = static_cast<double>(closes[i] + unzigzag(getVarint(p))) / scale;
+                out.high[i] = static_cast<double>(closes[i] + unzigzag(getVarint(p))) / scale;
+                out.low[i] = static_cast<double>(closes[i] + unzigzag(getVarint(p))) / scale;
+            }
+        }
+    } else {
+        BitReader closes(data + closeOffset);
+        xorDecode(closes, out.close.data(), count);
+        if (!closesOnly) {
+            BitReader others(data + otherOffset);
+            xorDecode(others, out.open.data(), count);
+            xorDecode(others, out.high.data(), count);
+            xorDecode(others, out.low.data(), count);
+        }
+    }
+
+    if (!closesOnly) {
+        p = data + volumeOffset;
+        for (uint32_t i = 0; i < count; i++) out.volume[i] = static_cast<long>(unzigzag(getVarint(p)));
+    }
+}
+
+const TickerSeries& CompressedCursor::rows() const {
+    return block < series->blocks.size() ? buffer : series->tail;
+}
+
+bool CompressedCursor::valid() const {
+    if (!series) return false;
+    const TickerSeries& r = rows();
+    return pos < r.size() && r.dates[pos] <= end;
+}
+
+void CompressedCursor::load(size_t index) {
+    block = index;
+    pos = 0;
+    if (index < series->blocks.size()) series->blocks[index].decode(buffer);
+}
+
+void CompressedCursor::next() {
+    if (++pos == rows().size() && block < series->blocks.size()) load(block + 1);
+}
+
+StockBar CompressedCursor::bar() const {
+    const TickerSeries& r = rows();
+    return { r.open[pos], r.close[pos], r.high[pos], r.low[pos], r.volume[pos] };
+}
+
+CompressedStore::CompressedStore() : rowCount(0) {}
+
+// Index of the first block whose last day is >= day; blocks.size() when
+// the day belongs in the tail.
+size_t CompressedStore::blockFor(const CompressedSeries& s, int day) {
+    auto it = std::lower_bound(s.blocks.begin(), s.blocks.end(), day,
+                               [](const HistoryBlock& b, int d) { return b.lastDay < d; });
+    return static_cast<size_t>(it - s.blocks.begin());
+}
+
+// Re-encodes block `index` from its decoded rows: dropped when empty,
+// split in two when a write has pushed it past BLOCK_ROWS.
+void CompressedStore::rewrite(CompressedSeries& s, size_t index, const TickerSeries& rows) {
+    const size_t n = rows.size();
+    if (n == 0) {
+        s.blocks.erase(s.blocks.begin() + index);
+    } else if (n > BLOCK_ROWS) {
+        s.blocks[index] = HistoryBlock::encode(rows, 0, n / 2);
+        s.blocks.insert(s.blocks.begin() + index + 1, HistoryBlock::encode(rows, n / 2, n));
+    } else {
+        s.blocks[index] = HistoryBlock::encode(rows, 0, n);
+    }
+}
+
+void CompressedStore::seal(CompressedSeries& s) {
+    s.blocks.push_back(HistoryBlock::encode(s.tail, 0, s.tail.size()));
+    s.tail = TickerSeries();
+}
+
+bool CompressedStore::insert(const StockData& data) {
+    int day;
+    if (!DateUtils::parseDate(data.date, day)) return false;
+    CompressedSeries& s = series[data.ticker];
+    size_t b = blockFor(s, day);
+    if (b == s.blocks.size()) {
+        size_t i = s.tail.lowerBound(day);
+        if (i < s.tail.size() && s.tail.dates[i] == day) return false;
+        s.tail.insertAt(i, day, data);
+        if (s.tail.size() >= BLOCK_ROWS) seal(s);
+    } else {
+        TickerSeries rows;
+        s.blocks[b].decode(rows);
+        size_t i = rows.lowerBound(day);
+        if (i < rows.size() && rows.dates[i] == day) return false;
+        rows.insertAt(i, day, data);
+        rewrite(s, b, rows);
+    }
+    rowCount++;
+    return true;
+}
+
+bool CompressedStore::search(const std::string& ticker, const std::string& date, StockData& out) const {
+    int day;
+    auto it = series.find(ticker);
+    if (it == series.end() || !DateUtils::parseDate(date, day)) return false;
+    CompressedCursor c = scan(ticker, day, day);
+    if (!c.valid()) return false;
+    StockBar bar = c.bar();
+    out = StockData(ticker, date, bar.openPrice, bar.closePrice, bar.highPrice, bar.lowPrice, bar.volume);
+    return true;
+}
+
+bool CompressedStore::update(const StockData& newData) {
+    int day;
+    auto it = series.find(newData.ticker);
+    if (it == series.end() || !DateUtils::parseDate(newData.date, day)) return false;
+    CompressedSeries& s = it->second;
+    size_t b = blockFor(s, day);
+    if (b == s.blocks.size()) {
+        size_t i = s.tail.lowerBound(day);
+        if (i == s.tail.size() || s.tail.dates[i] != day) return false;
+        s.tail.setAt(i, newData);
+        return true;
+    }
+    TickerSeries rows;
+    s.blocks[b].decode(rows);
+    size_t i = rows.lowerBound(day);
+    if (i == rows.size() || rows.dates[i] != day) return false;
+    rows.setAt(i, newData);
+    rewrite(s, b, rows);
+    return true;
+}
+
+bool CompressedStore::remove(const std::string& ticker, const std::string& date) {
+    int day;
+    auto it = series.find(ticker);
+    if (it == series.end() || !DateUtils::parseDate(date, day)) return false;
+    CompressedSeries& s = it->second;
+    size_t b = blockFor(s, day);
+    if (b == s.blocks.size()) {
+        size_t i = s.tail.lowerBound(day);
+        if (i == s.tail.size() || s.tail.dates[i] != day) return false;
+        s.tail.eraseAt(i);
+    } else {
+        TickerSeries rows;
+        s.blocks[b].decode(rows);
+        size_t i = rows.lowerBound(day);
+        if (i == rows.size() || rows.dates[i] != day) return false;
+        rows.eraseAt(i);
+        rewrite(s, b, rows);
+    }
+    if (s.blocks.empty() && s.tail.size() == 0) series.erase(it);
+    rowCount--;
+    return true;
+}
+
+size_t CompressedStore::loadFrom(const AVLTree& tree) {
+    size_t added = 0;
+    for (const std::string& ticker : tree.getTickers()) {
+        CompressedSeries& s = series[ticker];
+        for (RangeCursor c = tree.scanTicker(ticker); c.valid(); c.next()) {
+            int day = c.day();
+            int lastDay = s.tail.size() ? s.tail.dates.back() : (s.blocks.empty() ? INT_MIN : s.blocks.back().lastDay);
+            if (day > lastDay) {
+                // Date-order append straight onto the tail
+                s.tail.dates.push_back(day);
+                s.tail.open.push_back(c->openPrice);
+                s.tail.close.push_back(c->closePrice);
+                s.tail.high.push_back(c->highPrice);
+                s.tail.low.push_back(c->lowPrice);
+                s.tail.volume.push_back(c->volume);
+                if (s.tail.size() >= BLOCK_ROWS) seal(s);
+                rowCount++;
+                added++;
+            } else if (insert(tree.row(c))) {
+                added++;
+            }
+        }
+    }
+    compact();
+    return added;
+}
+
+void CompressedStore::compact() {
+    for (auto& entry : series)
+        if (entry.second.tail.size() > 0) seal(entry.second);
+}
+
+CompressedCursor CompressedStore::scan(const std::string& ticker, int startDay, int endDay) const {
+    CompressedCursor c;
+    auto it = series.find(ticker);
+    if (it == series.end() || startDay > endDay) return c;
+    c.series = &it->second;
+    c.end = endDay;
+    c.load(blockFor(it->second, startDay));
+    c.pos = c.rows().lowerBound(startDay);
+    return c;
+}
+
+std::vector<double> CompressedStore::closes(const std::string& ticker, int startDay, int endDay) const {
+    std::vector<double> result;
+    auto it = series.find(ticker);
+    if (it == series.end() || startDay > endDay) return result;
+    const CompressedSeries& s = it->second;
+    TickerSeries buffer;
+    for (size_t b = blockFor(s, startDay); b <= s.blocks.size(); b++) {
+        const TickerSeries* rows = &s.tail;
+        if (b < s.blocks.size()) {
+            if (s.blocks[b].firstDay > endDay) break;
+            s.blocks[b].decode(buffer, true);
+            rows = &buffer;
+        }
+        for (size_t i = rows->lowerBound(startDay); i < rows->size() && rows->dates[i] <= endDay; i++)
+            result.push_back(rows->close[i]);
+    }
+    return result;
+}
+
+std::vector<StockData> CompressedStore::getStocksByTicker(const std::string& ticker) const {
+    std::vector<StockData> result;
+    for (CompressedCursor c = scan(ticker, INT_MIN, INT_MAX); c.valid(); c.next()) {
+        StockBar bar = c.bar();
+        result.emplace_back(ticker, DateUtils::toDateString(c.day()), bar.openPrice, bar.closePrice,
+                            bar.highPrice, bar.lowPrice, bar.volume);
+    }
+    return result;
+}
+
+std::vector<StockData> CompressedStore::getStocksByDateRange(const std::string& ticker,
+                                                             const std::string& startDate,
+                                                             const std::string& endDate) const {
+    std::vector<StockData> result;
+    int startDay, endDay;
+    if (!DateUtils::parseDate(startDate, startDay) || !DateUtils::parseDate(endDate, endDay)) return result;
+    for (CompressedCursor c = scan(ticker, startDay, endDay); c.valid(); c.next()) {
+        StockBar bar = c.bar();
+        result.emplace_back(ticker, DateUtils::toDateString(c.day()), bar.openPrice, bar.closePrice,
+                            bar.highPrice, bar.lowPrice, bar.volume);
+    }
+    return result;
+}
+
+std::vector<std::string> CompressedStore::getTickers() const {
+    std::vector<std::string> tickers;
+    tickers.reserve(series.size());
+    for (const auto& entry : series) tickers.push_back(entry.first);
+    return tickers;
+}
+
+CompressionStats CompressedStore::stats() const {
+    CompressionStats st;
+    st.rows = rowCount;
+    st.rawBytes = rowCount * RAW_ROW_BYTES;
+    for (const auto& entry : series) {
+        st.blocks += entry.second.blocks.size();
+        for (const HistoryBlock& b : entry.second.blocks) st.storedBytes += sizeof(HistoryBlock) + b.bytes.size();
+        st.storedBytes += entry.second.tail.size() * RAW_ROW_BYTES;
+    }
+    return st;
+}
@@ -0,0 +1,122 @@
+#ifndef COMPRESSEDSTORE_H
+#define COMPRESSEDSTORE_H
+
+#include "SeriesStore.h"
+#include <climits>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Up to BLOCK_ROWS consecutive rows of one ticker, encoded column by
+// column into one byte buffer:
+//   dates    first day in the header, then varint day-to-day gaps
+//   prices   fixed-point when every price in the block is an exact
+//            multiple of 10^-priceDigits: close as a zigzag varint delta
+//            from the previous close, open/high/low as deltas from the
+//            same row's close. Otherwise Gorilla XOR bit streams, one per
+//            column, each value XORed with its predecessor.
+//   volumes  zigzag varints
+// Both price encodings are lossless.
+struct HistoryBlock {
+    static const uint8_t XOR_PRICES = 0xFF;     // priceDigits when not fixed-point
+
+    int firstDay = 0;
+    int lastDay = 0;
+    uint32_t count = 0;
+    uint8_t priceDigits = 0;
+    uint32_t closeOffset = 0;       // column starts within bytes; dates start at 0
+    uint32_t otherOffset = 0;       // open, high, low
+    uint32_t volumeOffset = 0;
+    std::vector<uint8_t> bytes;
+
+    static HistoryBlock encode(const TickerSeries& rows, size_t first, size_t last);
+    // Replaces `out`. With closesOnly, open/high/low/volume are left empty.
+    void decode(TickerSeries& out, bool closesOnly = false) const;
+};
+
+struct CompressedSeries {
+    std::vector<HistoryBlock> blocks;   // ascending, non-overlapping
+    TickerSeries tail;                  // rows after the last block, sealed once full
+};
+
+struct CompressionStats {
+    size_t rows = 0;
+    size_t blocks = 0;
+    size_t rawBytes = 0;            // 44 bytes per row: a date and five 8-byte numbers
+    size_t storedBytes = 0;         // encoded blocks, block headers and unsealed tails
+
+    double ratio() const { return storedBytes ? static_cast<double>(rawBytes) / storedBytes : 0; }
+    double bytesPerRow() const { return rows ? static_cast<double>(storedBytes) / rows : 0; }
+};
+
+// Forward cursor over one ticker's rows in [start, end], decoding one
+// block at a time into a reusable buffer. Any mutation of the store
+// invalidates it.
+class CompressedCursor {
+public:
+    CompressedCursor() : series(nullptr), block(0), pos(0), end(0) {}
+    bool valid() const;
+    void next();
+    int day() const { return rows().dates[pos]; }
+    StockBar bar() const;
+    double close() const { return rows().close[pos]; }
+
+private:
+    friend class CompressedStore;
+    const CompressedSeries* series;
+    size_t block;                   // blocks.size() while reading the tail
+    size_t pos;
+    TickerSeries buffer;            // the decoded block
+    int end;
+
+    const TickerSeries& rows() const;
+    void load(size_t index);
+};
+
+// Per-ticker history kept in compressed blocks: far more rows resident
+// per GB than AVLTree, at the cost of decoding a block (BLOCK_ROWS rows)
+// per scan step and re-encoding one per out-of-order write. Appends in date order go to an uncompressed tail that is sealed
+// into a block every BLOCK_ROWS rows. "--batch --store compressed" runs
+// on one of these.
+class CompressedStore : public HistoryStore {
+private:
+    std::map<std::string, CompressedSeries> series;
+    size_t rowCount;
+
+    static size_t blockFor(const CompressedSeries& s, int day);
+    static void rewrite(CompressedSeries& s, size_t index, const TickerSeries& rows);
+    static void seal(CompressedSeries& s);
+
+public:
+    static const size_t BLOCK_ROWS = 256;
+
+    CompressedStore();
+
+    // Same semantics as AVLTree: insert leaves an existing row alone.
+    bool insert(const StockData& data) override;
+    bool search(const std::string& ticker, const std::string& date, StockData& out) const override;
+    bool update(const StockData& newData) override;
+    bool remove(const std::string& ticker, const std::string& date) override;
+
+    // Appends every row of the tree (already in ticker/date order), then
+    // compacts.
+    size_t loadFrom(const AVLTree& tree);
+    // Seals every unsealed tail into a (possibly short) block.
+    void compact() override;
+
+    std::vector<StockData> getStocksByTicker(const std::string& ticker) const override;
+    std::vector<StockData> getStocksByDateRange(const std::string& ticker,
+                                                const std::string& startDate,
+                                                const std::string& endDate) const override;
+    CompressedCursor scan(const std::string& ticker, int startDay, int endDay) const;
+    // Close column only, for metrics; skips decoding the other columns.
+    std::vector<double> closes(const std::string& ticker, int startDay, int endDay) const override;
+
+    std::vector<std::string> getTickers() const override;
+    size_t size() const override { return rowCount; }
+    size_t bytesUsed() const override { return stats().storedBytes; }
+    CompressionStats stats() const;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#include "ConcurrentStore.h"
+#include <algorithm>
+
+// Nodes that were live in one version but not the next. Each bag keeps
+// every newer bag alive, and each published version holds its own bag, so
+// a bag is destroyed only after every version up to its own is released.
+struct ConcurrentStore::RetiredNodes {
+    SlabAllocator* arena;
+    std::vector<Node*> nodes;
+    std::shared_ptr<RetiredNodes> newer;
+
+    explicit RetiredNodes(SlabAllocator* arena) : arena(arena) {}
+
+    ~RetiredNodes() {
+        // May run on a reader thread, hence the shared release.
+        arena->releaseShared(reinterpret_cast<void* const*>(nodes.data()), nodes.size());
+        // Release the chain iteratively so a long run of released versions
+        // cannot overflow the stack through recursive destructors: nested
+        // destructors only queue their successor for the outermost one.
+        static thread_local bool draining = false;
+        static thread_local std::vector<std::shared_ptr<RetiredNodes>> pending;
+        if (newer) pending.push_back(std::move(newer));
+        if (draining) return;
+        draining = true;
+        while (!pending.empty()) {
+            std::shared_ptr<RetiredNodes> next = std::move(pending.back());
+            pending.pop_back();
+            next.reset();
+        }
+        draining = false;
+    }
+};
+
+ConcurrentStore::ConcurrentStore() {
+    master.enableCopyOnWrite();
+    master.addListener(this);
+    std::lock_guard<std::mutex> lock(writerMutex);
+    publish();
+}
+
+ConcurrentStore::~ConcurrentStore() {
+    master.removeListener(this);
+    std::atomic_store(&current, std::shared_ptr<const AVLTree>());
+    currentRetired.reset();
+}
+
+// Called with writerMutex held.
+void ConcurrentStore::publish() {
+    std::shared_ptr<RetiredNodes> bag = std::make_shared<RetiredNodes>(&master.arena);
+    if (currentRetired) {
+        master.beginEpoch(currentRetired->nodes);
+        currentRetired->newer = bag;
+    } else {
+        std::vector<Node*> none;
+        master.beginEpoch(none);
+    }
+    currentRetired = bag;
+
+    // The view's deleter owns its bag, tying node lifetime to readers.
+    std::shared_ptr<const AVLTree> view(master.makeView(), [bag](const AVLTree* tree) { delete tree; });
+    std::atomic_store(&current, view);
+
+    std::vector<Change> published;
+    published.swap(changes);
+    for (const Change& c : published)
+        for (TreeListener* listener : listeners) listener->onMutation(c.ticker, c.day, c.kind);
+}
+
+void ConcurrentStore::onMutation(const std::string& ticker, int day, MutationKind kind) {
+    if (!listeners.empty()) changes.push_back({ ticker, day, kind });
+}
+
+// Called by master with writerMutex held.
+bool ConcurrentStore::wantsEveryRow() const {
+    for (TreeListener* listener : listeners)
+        if (listener->wantsEveryRow()) return true;
+    return false;
+}
+
+void ConcurrentStore::addListener(TreeListener* listener) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    listeners.push_back(listener);
+}
+
+void ConcurrentStore::removeListener(TreeListener* listener) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
+}
+
+std::shared_ptr<const AVLTree> ConcurrentStore::snapshot() const {
+    return std::atomic_load(&current);
+}
+
+void ConcurrentStore::apply(const WriteBatch& batch) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    if (!batch.inserts.empty()) master.bulkLoad(batch.inserts);
+    for (const auto& row : batch.updates) master.update(row);
+    for (const auto& key : batch.removals) master.remove(key.first, key.second);
+    publish();
+}
+
+size_t ConcurrentStore::insertBatch(const std::vector<StockData>& rows) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    size_t added = master.bulkLoad(rows);
+    publish();
+    return added;
+}
+
+void ConcurrentStore::write(const std::function<void(AVLTree&)>& change) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    change(master);
+    publish();
+}
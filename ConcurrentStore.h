@@ -0,0 +1,105 @@
+#ifndef CONCURRENTSTORE_H
+#define CONCURRENTSTORE_H
+
+#include "AVLTree.h"
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A set of mutations applied and published together.
+struct WriteBatch {
+    std::vector<StockData> inserts;
+    std::vector<StockData> updates;
+    std::vector<std::pair<std::string, std::string>> removals;     // (ticker, date)
+
+    bool empty() const { return inserts.empty() && updates.empty() && removals.empty(); }
+};
+
+// Snapshot-isolated store. Writers are serialized and apply each batch to
+// a copy-on-write AVLTree, which path-copies only the nodes a batch
+// touches. The result is published as an immutable view, so readers
+// never see a half-applied batch and never wait for a writer to finish
+// one: taking a snapshot is a shared_ptr copy (std::atomic_load, which
+// the standard library guards with a short internal lock, not the
+// writer's).
+//
+// Replaced nodes are reclaimed by epoch: the nodes retired while building
+// version v + 1 are freed once no reader holds version v or anything
+// older. Snapshots must not outlive the store.
+class ConcurrentStore : private TreeListener {
+private:
+    struct RetiredNodes;
+    struct Change {
+        std::string ticker;
+        int day;
+        MutationKind kind;
+    };
+
+    AVLTree master;
+    std::mutex writerMutex;
+    std::shared_ptr<const AVLTree> current;
+    std::shared_ptr<RetiredNodes> currentRetired;
+    std::vector<TreeListener*> listeners;
+    std::vector<Change> changes;    // made to master since the last publish
+
+    void publish();
+
+    // Queues master's notifications until the version holding them is out
+    void onMutation(const std::string& ticker, int day, MutationKind kind) override;
+    bool wantsEveryRow() const override;
+
+public:
+    ConcurrentStore();
+    ~ConcurrentStore();
+    ConcurrentStore(const ConcurrentStore&) = delete;
+    ConcurrentStore& operator=(const ConcurrentStore&) = delete;
+
+    // The latest published version; the returned tree never changes.
+    std::shared_ptr<const AVLTree> snapshot() const;
+
+    // Each call applies its whole batch, then publishes one new version.
+    void apply(const WriteBatch& batch);
+    size_t insertBatch(const std::vector<StockData>& rows);     // via AVLTree::bulkLoad
+    // Runs `change` on the writable tree with the writer lock held, then
+    // publishes. For anything the batch calls do not cover (CSV and
+    // snapshot loads, write-ahead log recovery); `change` must not keep
+    // the reference.
+    void write(const std::function<void(AVLTree&)>& change);
+
+    // Listeners hear about each mutation once the version holding it has
+    // been published, so a snapshot taken from inside onMutation already
+    // shows it. They run on the writing thread with the writer lock held
+    // and must not write to the store.
+    void addListener(TreeListener* listener);
+    void removeListener(TreeListener* listener);
+};
+
+// What a cache reads and listens to: a plain tree, or a ConcurrentStore
+// whose latest snapshot is read each time.
+class TreeSource {
+private:
+    AVLTree* tree;
+    ConcurrentStore* store;
+
+public:
+    explicit TreeSource(AVLTree& tree) : tree(&tree), store(nullptr) {}
+    explicit TreeSource(ConcurrentStore& store) : tree(nullptr), store(&store) {}
+
+    // Keeps a store snapshot alive while it is read; a plain tree is not owned.
+    std::shared_ptr<const AVLTree> pin() const {
+        return store ? store->snapshot() : std::shared_ptr<const AVLTree>(std::shared_ptr<const AVLTree>(), tree);
+    }
+    void addListener(TreeListener* listener) {
+        if (store) store->addListener(listener);
+        else tree->addListener(listener);
+    }
+    void removeListener(TreeListener* listener) {
+        if (store) store->removeListener(listener);
+        else tree->removeListener(listener);
+    }
+};
+
+#endif
@@ -0,0 +1,170 @@
+#include "Correlation.h"
+#include "SimdKernels.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const size_t TILE = 64;
+
+    struct Series {
+        std::vector<int> days;
+        std::vector<double> closes;
+    };
+
+    double simpleReturn(double previous, double close) {
+        return previous > 0 ? close / previous - 1 : 0;
+    }
+
+    // Sorted intersection of two sorted day lists, written over `common`.
+    void intersect(std::vector<int>& common, const std::vector<int>& days) {
+        size_t kept = 0, j = 0;
+        for (size_t i = 0; i < common.size(); i++) {
+            while (j < days.size() && days[j] < common[i]) j++;
+            if (j < days.size() && days[j] == common[i]) common[kept++] = common[i];
+        }
+        common.resize(kept);
+    }
+
+    // out[i][j] (i in [i0, i1), j in [j0, j1)) = sum over rows of x[t][i] * x[t][j],
+    // accumulated in a local tile and written to both triangles.
+    void productTile(const double* x, size_t rows, size_t n, size_t i0, size_t i1,
+                     size_t j0, size_t j1, double* out) {
+        double acc[TILE * TILE] = {};
+        const size_t width = j1 - j0;
+        for (size_t t = 0; t < rows; t++) {
+            const double* row = x + t * n;
+            size_t i = i0;
+            for (; i + 4 <= i1; i += 4)
+                SimdKernels::rank4Update(acc + (i - i0) * TILE, TILE, row + i, row + j0, width);
+            for (; i < i1; i++)
+                SimdKernels::axpy(acc + (i - i0) * TILE, row[i], row + j0, width);
+        }
+        for (size_t i = i0; i < i1; i++) {
+            for (size_t j = j0; j < j1; j++) {
+                out[i * n + j] = acc[(i - i0) * TILE + (j - j0)];
+                out[j * n + i] = acc[(i - i0) * TILE + (j - j0)];
+            }
+        }
+    }
+}
+
+CorrelationMatrix::CorrelationMatrix() : count(0), firstDay(0), lastDay(0) {}
+
+void CorrelationMatrix::multiply(const std::vector<double>& returns, size_t rows, ThreadPool& pool) {
+    const size_t n = names.size();
+    const size_t blocks = (n + TILE - 1) / TILE;
+    std::vector<std::pair<size_t, size_t>> tiles;
+    for (size_t bi = 0; bi < blocks; bi++)
+        for (size_t bj = bi; bj < blocks; bj++) tiles.push_back({ bi, bj });
+
+    products.assign(n * n, 0);
+    pool.parallelFor(tiles.size(), [&](size_t k) {
+        size_t i0 = tiles[k].first * TILE, j0 = tiles[k].second * TILE;
+        productTile(returns.data(), rows, n, i0, std::min(i0 + TILE, n), j0, std::min(j0 + TILE, n),
+                    products.data());
+    });
+}
+
+bool CorrelationMatrix::build(const AVLTree& tree, const std::vector<std::string>& tickers, int startDay,
+                              int endDay, ThreadPool& pool, std::string& error) {
+    *this = CorrelationMatrix();
+    const size_t n = tickers.size();
+    if (n == 0) {
+        error = "no tickers given";
+        return false;
+    }
+
+    std::vector<Series> series(n);
+    pool.parallelFor(n, [&](size_t i) {
+        for (RangeCursor c = tree.scanDays(tickers[i], startDay, endDay); c.valid(); c.next()) {
+            series[i].days.push_back(c.day());
+            series[i].closes.push_back(c->closePrice);
+        }
+    });
+    for (size_t i = 0; i < n; i++) {
+        if (series[i].days.empty()) {
+            error = "no data for " + tickers[i];
+            return false;
+        }
+    }
+
+    std::vector<int> common = series[0].days;
+    for (size_t i = 1; i < n && !common.empty(); i++) intersect(common, series[i].days);
+    if (common.size() < 2) {
+        error = "the tickers share fewer than two dates";
+        return false;
+    }
+
+    // Day-major returns between consecutive common dates, shifted by
+    // each column's mean.
+    const size_t rows = common.size() - 1;
+    std::vector<double> returns(rows * n);
+    names = tickers;
+    shift.assign(n, 0);
+    sums.assign(n, 0);
+    lastClose.assign(n, 0);
+    pool.parallelFor(n, [&](size_t i) {
+        const Series& s = series[i];
+        size_t at = 0;
+        double previous = 0;
+        for (size_t t = 0; t < common.size(); t++) {
+            while (s.days[at] != common[t]) at++;
+            if (t > 0) returns[(t - 1) * n + i] = simpleReturn(previous, s.closes[at]);
+            previous = s.closes[at];
+        }
+        lastClose[i] = previous;
+        double mean = 0;
+        for (size_t t = 0; t < rows; t++) mean += returns[t * n + i];
+        mean /= rows;
+        double sum = 0;
+        for (size_t t = 0; t < rows; t++) {
+            returns[t * n + i] -= mean;
+            sum += returns[t * n + i];
+        }
+        shift[i] = mean;
+        sums[i] = sum;
+    });
+
+    multiply(returns, rows, pool);
+    count = rows;
+    firstDay = common.front();
+    lastDay = common.back();
+    return true;
+}
+
+bool CorrelationMatrix::appendCloses(int day, const std::vector<double>& closes) {
+    const size_t n = names.size();
+    if (n == 0 || day <= lastDay || closes.size() != n) return false;
+    std::vector<double> x(n);
+    for (size_t i = 0; i < n; i++) {
+        x[i] = simpleReturn(lastClose[i], closes[i]) - shift[i];
+        sums[i] += x[i];
+    }
+    for (size_t i = 0; i < n; i++) SimdKernels::axpy(&products[i * n], x[i], x.data(), n);
+    lastClose = closes;
+    lastDay = day;
+    count++;
+    return true;
+}
+
+bool CorrelationMatrix::appendDay(const AVLTree& tree, int day) {
+    std::vector<double> closes(names.size());
+    for (size_t i = 0; i < names.size(); i++) {
+        StockBar bar;
+        if (!tree.searchBar(names[i], day, bar)) return false;
+        closes[i] = bar.closePrice;
+    }
+    return appendCloses(day, closes);
+}
+
+double CorrelationMatrix::covariance(size_t i, size_t j) const {
+    if (count == 0) return 0;
+    const size_t n = names.size();
+    return (products[i * n + j] - sums[i] * sums[j] / count) / count;
+}
+
+double CorrelationMatrix::correlation(size_t i, size_t j) const {
+    double vi = covariance(i, i), vj = covariance(j, j);
+    if (vi <= 0 || vj <= 0) return 0;
+    return std::max(-1.0, std::min(1.0, covariance(i, j) / std::sqrt(vi * vj)));
+}
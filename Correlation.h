@@ -0,0 +1,64 @@
+#ifndef CORRELATION_H
+#define CORRELATION_H
+
+#include "AVLTree.h"
+#include "ThreadPool.h"
+#include <climits>
+#include <string>
+#include <vector>
+
+// Pairwise covariance and correlation of daily close-to-close returns
+// across a set of tickers. Series are aligned on the dates every ticker
+// has a row for, and a return is taken between consecutive common dates,
+// so one ticker with a short history narrows the window for all of them.
+// Covariances are population (divided by the observation count), like
+// FinancialMetrics::calculateVolatility.
+//
+// build() lays the returns out day-major (one row of N returns per date)
+// and forms the N x N product matrix in 64 x 64 tiles spread over the
+// pool, each tile streaming its two column slices through SIMD rank-4
+// updates while its accumulators stay in cache. appendDay() folds one new
+// common date in with a rank-1 update, O(N^2), without revisiting history.
+//
+// Returns are shifted by each ticker's mean at build time before being
+// multiplied, which keeps the running sums small and avoids cancellation
+// when covariances are read back.
+class CorrelationMatrix {
+private:
+    std::vector<std::string> names;
+    std::vector<double> shift;          // per ticker
+    std::vector<double> sums;           // sum of shifted returns, per ticker
+    std::vector<double> products;       // N x N, row-major: sum of shifted return products
+    std::vector<double> lastClose;      // at lastDay, for the next appended return
+    size_t count;                       // return observations
+    int firstDay;                       // common dates covered
+    int lastDay;
+
+    void multiply(const std::vector<double>& returns, size_t rows, ThreadPool& pool);
+
+public:
+    CorrelationMatrix();
+
+    // Aligns the tickers' closes in [startDay, endDay] and computes the
+    // matrix. Fails if a ticker has no rows or fewer than two dates are
+    // shared by all of them.
+    bool build(const AVLTree& tree, const std::vector<std::string>& tickers, int startDay, int endDay,
+               ThreadPool& pool, std::string& error);
+
+    // Adds the returns into `day`, which must come after lastDate().
+    // `closes` is in tickers() order; appendDay reads them from the tree
+    // and returns false (changing nothing) unless every ticker has a row.
+    bool appendCloses(int day, const std::vector<double>& closes);
+    bool appendDay(const AVLTree& tree, int day);
+
+    size_t size() const { return names.size(); }
+    size_t observations() const { return count; }
+    const std::vector<std::string>& tickers() const { return names; }
+    int firstDate() const { return firstDay; }
+    int lastDate() const { return lastDay; }
+
+    double covariance(size_t i, size_t j) const;
+    double correlation(size_t i, size_t j) const;  // 0 when either series is flat
+};
+
+#endif
@@ -0,0 +1,136 @@
+#include "CsvExporter.h"
+#include "DateUtils.h"
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+    const size_t BUFFER_BYTES = 1 << 20;
+    const size_t MAX_ROW_BYTES = 512;   // 5 shortest-form numbers + ticker + date
+
+    class BufferedFile {
+    private:
+        FILE* out;
+        std::vector<char> buffer;
+        size_t used;
+        bool failed;
+
+    public:
+        explicit BufferedFile(FILE* f) : out(f), buffer(BUFFER_BYTES), used(0), failed(false) {}
+
+        // Ensures at least n free bytes and returns the write position.
+        char* reserve(size_t n) {
+            if (buffer.size() - used < n) flush();
+            return buffer.data() + used;
+        }
+        void commit(char* end) { used = end - buffer.data(); }
+
+        void append(const char* s, size_t n) {
+            char* p = reserve(n);
+            memcpy(p, s, n);
+            commit(p + n);
+        }
+
+        bool flush() {
+            if (used && fwrite(buffer.data(), 1, used, out) != used) failed = true;
+            used = 0;
+            return !failed;
+        }
+    };
+
+    template <typename T>
+    char* putNumber(char* p, char* end, T value) {
+        return std::to_chars(p, end, value).ptr;
+    }
+
+    void writeRow(BufferedFile& out, const std::string& ticker, int day, const StockBar& bar) {
+        char* p = out.reserve(MAX_ROW_BYTES + ticker.size());
+        char* end = p + MAX_ROW_BYTES + ticker.size();
+        memcpy(p, ticker.data(), ticker.size());
+        p += ticker.size();
+        *p++ = ',';
+        DateUtils::formatDate(day, p);
+        p += 10;
+        *p++ = ',';
+        p = putNumber(p, end, bar.openPrice);
+        *p++ = ',';
+        p = putNumber(p, end, bar.closePrice);
+        *p++ = ',';
+        p = putNumber(p, end, bar.highPrice);
+        *p++ = ',';
+        p = putNumber(p, end, bar.lowPrice);
+        *p++ = ',';
+        p = putNumber(p, end, bar.volume);
+        *p++ = '\n';
+        out.commit(p);
+    }
+
+    const char HEADER[] = "Ticker,Date,Open,Close,High,Low,Volume\n";
+}
+
+bool CsvExporter::checkDates(const CsvExportFilter& filter, std::string& error) {
+    int day;
+    if (!filter.startDate.empty() && !DateUtils::parseDate(filter.startDate, day)) {
+        error = "invalid start date " + filter.startDate + " (expected YYYY-MM-DD)";
+        return false;
+    }
+    if (!filter.endDate.empty() && !DateUtils::parseDate(filter.endDate, day)) {
+        error = "invalid end date " + filter.endDate + " (expected YYYY-MM-DD)";
+        return false;
+    }
+    return true;
+}
+
+bool CsvExporter::exportFile(const AVLTree& tree, const std::string& filename,
+                             const CsvExportFilter& filter, size_t& rowsWritten) {
+    rowsWritten = 0;
+    std::string error;
+    if (!checkDates(filter, error)) return false;
+    FILE* f = fopen(filename.c_str(), "wb");
+    if (!f) return false;
+
+    BufferedFile out(f);
+    out.append(HEADER, sizeof(HEADER) - 1);
+
+    const std::string startDate = filter.startDate.empty() ? "0000-01-01" : filter.startDate;
+    const std::string endDate = filter.endDate.empty() ? "9999-12-31" : filter.endDate;
+    const std::vector<std::string> tickers = filter.tickers.empty() ? tree.getTickers() : filter.tickers;
+    for (const auto& ticker : tickers) {
+        for (RangeCursor c = tree.scanDateRange(ticker, startDate, endDate); c.valid(); c.next()) {
+            writeRow(out, ticker, keyDay(c.key()), *c);
+            rowsWritten++;
+        }
+    }
+
+    bool ok = out.flush();
+    return (fclose(f) == 0) && ok;
+}
+
+bool CsvExporter::exportFile(const HistoryStore& store, const std::string& filename,
+                             const CsvExportFilter& filter, size_t& rowsWritten) {
+    rowsWritten = 0;
+    std::string error;
+    if (!checkDates(filter, error)) return false;
+    FILE* f = fopen(filename.c_str(), "wb");
+    if (!f) return false;
+
+    BufferedFile out(f);
+    out.append(HEADER, sizeof(HEADER) - 1);
+
+    const std::string startDate = filter.startDate.empty() ? "0000-01-01" : filter.startDate;
+    const std::string endDate = filter.endDate.empty() ? "9999-12-31" : filter.endDate;
+    const std::vector<std::string> tickers = filter.tickers.empty() ? store.getTickers() : filter.tickers;
+    for (const auto& ticker : tickers) {
+        // One ticker's rows at a time, so memory stays bounded by the longest history
+        for (const StockData& row : store.getStocksByDateRange(ticker, startDate, endDate)) {
+            int day;
+            DateUtils::parseDate(row.date, day);
+            writeRow(out, ticker, day, toStockBar(row));
+            rowsWritten++;
+        }
+    }
+
+    bool ok = out.flush();
+    return (fclose(f) == 0) && ok;
+}
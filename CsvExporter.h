@@ -0,0 +1,29 @@
+#ifndef CSVEXPORTER_H
+#define CSVEXPORTER_H
+
+#include "AVLTree.h"
+#include "HistoryStore.h"
+#include <string>
+#include <vector>
+
+struct CsvExportFilter {
+    std::vector<std::string> tickers;   // empty exports every ticker
+    std::string startDate;              // empty means unbounded
+    std::string endDate;
+};
+
+// Writes "Ticker,Date,Open,Close,High,Low,Volume" rows by walking the tree
+// with cursors and formatting with std::to_chars into a 1 MiB buffer, so
+// memory use does not grow with the size of the store. A start or end
+// date that is not YYYY-MM-DD fails checkDates and exportFile returns
+// false before the file is opened, so an existing file is left intact.
+namespace CsvExporter {
+    bool checkDates(const CsvExportFilter& filter, std::string& error);
+    bool exportFile(const AVLTree& tree, const std::string& filename,
+                    const CsvExportFilter& filter, size_t& rowsWritten);
+    // Same output from a HistoryStore, one ticker's rows at a time.
+    bool exportFile(const HistoryStore& store, const std::string& filename,
+                    const CsvExportFilter& filter, size_t& rowsWritten);
+}
+
+#endif
@@ -0,0 +1,151 @@
+#include "CsvLoader.h"
+#include "DateUtils.h"
+#include "Instrumentation.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <thread>
+
+namespace {
+    const size_t MIN_CHUNK_BYTES = 1 << 20;
+
+    struct ChunkResult {
+        std::vector<StockData> rows;
+        std::vector<CsvError> errors;   // line is relative to the chunk start
+        size_t errorCount = 0;
+        size_t lineCount = 0;
+    };
+
+    template <typename T>
+    bool parseNumber(const char* first, const char* last, T& value) {
+        auto res = std::from_chars(first, last, value);
+        return res.ec == std::errc() && res.ptr == last;
+    }
+
+    const char* parseRow(const char* begin, const char* end, StockData& row) {
+        const char* fields[7];
+        const char* fieldEnds[7];
+        int count = 0;
+        const char* p = begin;
+        while (true) {
+            const char* comma = static_cast<const char*>(memchr(p, ',', end - p));
+            const char* fieldEnd = comma ? comma : end;
+            if (count == 7) return "too many fields";
+            fields[count] = p;
+            fieldEnds[count] = fieldEnd;
+            count++;
+            if (!comma) break;
+            p = comma + 1;
+        }
+        if (count != 7) return "expected 7 fields";
+        if (fields[0] == fieldEnds[0]) return "empty ticker";
+
+        int day;
+        if (!DateUtils::parseDate(fields[1], fieldEnds[1] - fields[1], day)) return "invalid date";
+        if (!parseNumber(fields[2], fieldEnds[2], row.openPrice)) return "invalid open price";
+        if (!parseNumber(fields[3], fieldEnds[3], row.closePrice)) return "invalid close price";
+        if (!parseNumber(fields[4], fieldEnds[4], row.highPrice)) return "invalid high price";
+        if (!parseNumber(fields[5], fieldEnds[5], row.lowPrice)) return "invalid low price";
+        if (!parseNumber(fields[6], fieldEnds[6], row.volume)) return "invalid volume";
+        row.ticker.assign(fields[0], fieldEnds[0]);
+        row.date.assign(fields[1], fieldEnds[1]);
+        return nullptr;
+    }
+
+    void parseChunk(const char* begin, const char* end, ChunkResult& out) {
+        out.rows.reserve((end - begin) / 48);
+        StockData row;
+        const char* p = begin;
+        while (p < end) {
+            const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+            const char* lineEnd = nl ? nl : end;
+            const char* next = nl ? nl + 1 : end;
+            if (lineEnd > p && lineEnd[-1] == '\r') lineEnd--;
+            out.lineCount++;
+            if (lineEnd > p) {
+                const char* reason = parseRow(p, lineEnd, row);
+                if (!reason) {
+                    out.rows.push_back(row);
+                } else {
+                    if (out.errors.size() < CsvLoader::MAX_REPORTED_ERRORS)
+                        out.errors.push_back({ out.lineCount, reason });
+                    out.errorCount++;
+                }
+            }
+            p = next;
+        }
+    }
+
+    const char* nextLineStart(const char* p, const char* end) {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+        return nl ? nl + 1 : end;
+    }
+}
+
+bool CsvLoader::parseFile(const std::string& filename, CsvLoadResult& result, unsigned threads) {
+    MappedFile file;
+    if (!file.open(filename)) return false;
+    result = CsvLoadResult();
+    if (file.size() == 0) return true;
+
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    const char* body = nextLineStart(begin, end);   // Skip header
+
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t bodyBytes = end - body;
+    size_t maxChunks = std::max<size_t>(1, bodyBytes / MIN_CHUNK_BYTES);
+    size_t chunkCount = std::min<size_t>(threads, maxChunks);
+
+    // Cut at the first line start after each even split point.
+    std::vector<const char*> bounds(1, body);
+    for (size_t i = 1; i < chunkCount; i++) {
+        const char* cut = nextLineStart(body + bodyBytes * i / chunkCount, end);
+        if (cut > bounds.back()) bounds.push_back(cut);
+    }
+    bounds.push_back(end);
+    chunkCount = bounds.size() - 1;
+
+    std::vector<ChunkResult> chunks(chunkCount);
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < chunkCount; i++)
+        workers.emplace_back(parseChunk, bounds[i], bounds[i + 1], std::ref(chunks[i]));
+    parseChunk(bounds[0], bounds[1], chunks[0]);
+    for (auto& w : workers) w.join();
+
+    size_t totalRows = 0;
+    for (const auto& c : chunks) totalRows += c.rows.size();
+    result.rows.reserve(totalRows);
+
+    size_t lineOffset = 1;
+    for (auto& c : chunks) {
+        result.rows.insert(result.rows.end(),
+                           std::make_move_iterator(c.rows.begin()),
+                           std::make_move_iterator(c.rows.end()));
+        for (auto& e : c.errors) {
+            if (result.errors.size() == MAX_REPORTED_ERRORS) break;
+            result.errors.push_back({ e.line + lineOffset, std::move(e.reason) });
+        }
+        result.errorCount += c.errorCount;
+        lineOffset += c.lineCount;
+    }
+    result.lineCount = lineOffset;
+    return true;
+}
+
+bool CsvLoader::importFile(AVLTree& tree, const std::string& filename, CsvLoadResult& result, unsigned threads) {
+    MM_PROBE_INGEST(Csv, result.rows.size());
+    if (!parseFile(filename, result, threads)) return false;
+    tree.bulkLoad(result.rows);
+    return true;
+}
+
+bool CsvLoader::importFile(HistoryStore& store, const std::string& filename, CsvLoadResult& result, unsigned threads) {
+    MM_PROBE_INGEST(Csv, result.rows.size());
+    if (!parseFile(filename, result, threads)) return false;
+    for (const StockData& row : result.rows) store.insert(row);
+    return true;
+}
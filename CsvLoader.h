@@ -0,0 +1,35 @@
+#ifndef CSVLOADER_H
+#define CSVLOADER_H
+
+#include "AVLTree.h"
+#include "HistoryStore.h"
+#include <string>
+#include <vector>
+
+struct CsvError {
+    size_t line;            // 1-based, header is line 1
+    std::string reason;
+};
+
+struct CsvLoadResult {
+    std::vector<StockData> rows;    // in file order
+    std::vector<CsvError> errors;   // first MAX_REPORTED_ERRORS only
+    size_t errorCount = 0;
+    size_t lineCount = 0;
+};
+
+// Loader for "Ticker,Date,Open,Close,High,Low,Volume" files. The file is
+// memory-mapped, split into chunks on line boundaries and parsed on
+// several threads with std::from_chars, so no per-field strings are built.
+// importFile then hands the parsed rows to AVLTree::bulkLoad, or inserts
+// them into a HistoryStore in file order.
+namespace CsvLoader {
+    const size_t MAX_REPORTED_ERRORS = 100;
+
+    // threads == 0 picks std::thread::hardware_concurrency().
+    bool parseFile(const std::string& filename, CsvLoadResult& result, unsigned threads = 0);
+    bool importFile(AVLTree& tree, const std::string& filename, CsvLoadResult& result, unsigned threads = 0);
+    bool importFile(HistoryStore& store, const std::string& filename, CsvLoadResult& result, unsigned threads = 0);
+}
+
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+// Calendar helpers for storing dates as integer day numbers
+// (days since 1970-01-01) instead of "YYYY-MM-DD" strings.
+namespace DateUtils {
+    inline int daysFromCivil(int y, unsigned m, unsigned d) {
+        y -= m <= 2;
+        const int era = (y >= 0 ? y : y - 399) / 400;
+        const unsigned yoe = static_cast<unsigned>(y - era * 400);
+        const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<int>(doe) - 719468;
+    }
+
+    inline void civilFromDays(int z, int& y, unsigned& m, unsigned& d) {
+        z += 719468;
+        const int era = (z >= 0 ? z : z - 146096) / 146097;
+        const unsigned doe = static_cast<unsigned>(z - era * 146097);
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned mp = (5 * doy + 2) / 153;
+        d = doy - (153 * mp + 2) / 5 + 1;
+        m = mp < 10 ? mp + 3 : mp - 9;
+        y = static_cast<int>(yoe) + era * 400 + (m <= 2);
+    }
+
+    inline bool isLeapYear(int y) {
+        return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+    }
+
+    inline unsigned daysInMonth(int y, unsigned m) {
+        static const unsigned table[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        return (m == 2 && isLeapYear(y)) ? 29 : table[m - 1];
+    }
+
+    // Parses exactly "YYYY-MM-DD". Returns false on anything else.
+    inline bool parseDate(const char* s, size_t len, int& days) {
+        if (len != 10 || s[4] != '-' || s[7] != '-') return false;
+        int parts[3] = { 0, 0, 0 };
+        const int starts[3] = { 0, 5, 8 };
+        const int lengths[3] = { 4, 2, 2 };
+        for (int p = 0; p < 3; p++) {
+            for (int i = 0; i < lengths[p]; i++) {
+                char c = s[starts[p] + i];
+                if (c < '0' || c > '9') return false;
+                parts[p] = parts[p] * 10 + (c - '0');
+            }
+        }
+        if (parts[1] < 1 || parts[1] > 12) return false;
+        if (parts[2] < 1 || static_cast<unsigned>(parts[2]) > daysInMonth(parts[0], parts[1])) return false;
+        days = daysFromCivil(parts[0], parts[1], parts[2]);
+        return true;
+    }
+
+    inline bool parseDate(const std::string& s, int& days) {
+        return parseDate(s.data(), s.size(), days);
+    }
+
+    // Writes the 10 characters of "YYYY-MM-DD" to out (no terminator).
+    inline void formatDate(int days, char* out) {
+        int y;
+        unsigned m, d;
+        civilFromDays(days, y, m, d);
+        for (int i = 3; i >= 0; i--) { out[i] = static_cast<char>('0' + y % 10); y /= 10; }
+        out[4] = '-';
+        out[5] = static_cast<char>('0' + m / 10);
+        out[6] = static_cast<char>('0' + m % 10);
+        out[7] = '-';
+        out[8] = static_cast<char>('0' + d / 10);
+        out[9] = static_cast<char>('0' + d % 10);
+    }
+
+    inline std::string toDateString(int days) {
+        char buf[10];
+        formatDate(days, buf);
+        return std::string(buf, 10);
+    }
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include <cmath>
+#include "SimdKernels.h"
 
 namespace FinancialMetrics {
     inline double calculateSMA(const std::vector<StockData>& stocks, int period) {
@@ -20,13 +21,62 @@ namespace FinancialMetrics {
         return ema;
     }
 
+    // Single pass (Welford) population standard deviation of closes.
     inline double calculateVolatility(const std::vector<StockData>& stocks) {
         if (stocks.empty()) return 0;
-        double mean = calculateSMA(stocks, stocks.size());
-        double variance = 0;
-        for (const auto& s : stocks)
-            variance += pow(s.closePrice - mean, 2);
-        return sqrt(variance / stocks.size());
+        double mean = 0, m2 = 0;
+        size_t n = 0;
+        for (const auto& s : stocks) {
+            double delta = s.closePrice - mean;
+            mean += delta / ++n;
+            m2 += delta * (s.closePrice - mean);
+        }
+        return sqrt(m2 / n);
+    }
+
+    // Overloads over a contiguous close-price column, backed by the
+    // runtime-dispatched kernels in SimdKernels.
+    inline double calculateSMA(const double* closes, size_t n, int period) {
+        if (period <= 0 || n < static_cast<size_t>(period)) return 0;
+        return SimdKernels::mean(closes, period);
+    }
+
+    inline double calculateEMA(const double* closes, size_t n, int period) {
+        if (period <= 0 || n < static_cast<size_t>(period)) return 0;
+        double multiplier = 2.0 / (period + 1);
+        double ema = calculateSMA(closes, n, period);
+        for (size_t i = period; i < n; i++)
+            ema = (closes[i] * multiplier) + ema * (1 - multiplier);
+        return ema;
+    }
+
+    inline double calculateVolatility(const double* closes, size_t n) {
+        if (n == 0) return 0;
+        return sqrt(SimdKernels::variance(closes, n));
+    }
+
+    inline std::vector<double> calculateReturns(const double* closes, size_t n) {
+        std::vector<double> out(n > 1 ? n - 1 : 0);
+        SimdKernels::returns(closes, n, out.data());
+        return out;
+    }
+
+    inline std::vector<double> calculateLogReturns(const double* closes, size_t n) {
+        std::vector<double> out(n > 1 ? n - 1 : 0);
+        SimdKernels::logReturns(closes, n, out.data());
+        return out;
+    }
+
+    inline double calculateSMA(const std::vector<double>& closes, int period) {
+        return calculateSMA(closes.data(), closes.size(), period);
+    }
+
+    inline double calculateEMA(const std::vector<double>& closes, int period) {
+        return calculateEMA(closes.data(), closes.size(), period);
+    }
+
+    inline double calculateVolatility(const std::vector<double>& closes) {
+        return calculateVolatility(closes.data(), closes.size());
     }
 
     inline double dailyPriceChange(double open, double close) {
@@ -0,0 +1,37 @@
+#ifndef HISTORYSTORE_H
+#define HISTORYSTORE_H
+
+#include "AVLTree.h"
+#include <string>
+#include <vector>
+
+// Row storage the batch runner can hold its data in instead of an
+// AVLTree (see "--store" in BatchRunner.h). Same CRUD semantics as the
+// tree: insert leaves an existing (ticker, date) alone, update and remove
+// report whether the row existed. Const calls may run concurrently.
+class HistoryStore {
+public:
+    virtual ~HistoryStore() {}
+
+    virtual bool insert(const StockData& data) = 0;
+    virtual bool search(const std::string& ticker, const std::string& date, StockData& out) const = 0;
+    virtual bool update(const StockData& newData) = 0;
+    virtual bool remove(const std::string& ticker, const std::string& date) = 0;
+
+    virtual std::vector<StockData> getStocksByTicker(const std::string& ticker) const = 0;
+    virtual std::vector<StockData> getStocksByDateRange(const std::string& ticker,
+                                                        const std::string& startDate,
+                                                        const std::string& endDate) const = 0;
+    // Closes of ticker's rows in [startDay, endDay], oldest first, for metrics
+    virtual std::vector<double> closes(const std::string& ticker, int startDay, int endDay) const = 0;
+
+    // Tickers with at least one row, alphabetically
+    virtual std::vector<std::string> getTickers() const = 0;
+    virtual size_t size() const = 0;
+    // Heap bytes holding rows, for comparing against AVLTree::memoryStats()
+    virtual size_t bytesUsed() const = 0;
+    // Called after a bulk import; stores that buffer appends pack them here.
+    virtual void compact() {}
+};
+
+#endif
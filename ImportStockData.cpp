@@ -1,62 +1,387 @@
-#include "ImportStockData.h"
-
-std::string GET_API_KEY(const std::string& filePath) {
-	std::ifstream config(filePath);
-	std::string API_KEY;
-
-	std::getline(config, API_KEY);
-	API_KEY = API_KEY.substr(8); // Remove "API_KEY=" prefix
-
-	config.close();
-	return API_KEY;
-}
-
-void importData(AVLTree& stockTree, std::string ticker) {
-    // Fetch from config file
-    std::string configData = GET_API_KEY("config.txt");
-    char* API_KEY = new char[configData.length() + 1];
-    std::strcpy(API_KEY, configData.c_str());
-
-    char* symbol = new char[ticker.length() + 1];
-    std::strcpy(symbol, ticker.c_str());
-
-    // Create the URI
-    uri_builder builder(U("https://api.stockdata.org/v1/data/eod"));
-    builder.append_query(U("symbols"), symbol);
-    builder.append_query(U("api_token"), API_KEY);
-    builder.append_query(U("date_from"), ("2025-01-01")); // Date to get stocks from onward.
-
-    // Make the HTTP request
-    http_client client(builder.to_uri());
-
-    client.request(methods::GET).then([&stockTree, &ticker](http_response response) {
-        if (response.status_code() == status_codes::OK) {
-            // Parse the JSON response
-            json::value json_response = response.extract_json().get();
-
-            auto data = json_response[U("data")].as_array();
-            if (data.size() != 0) {
-                for (auto& entry : data) {
-                    std::string dateTime = utility::conversions::to_utf8string(entry[U("date")].as_string());
-                    std::string date = dateTime.substr(0, dateTime.find('T')); // Extract only YYYY-MM-DD
-
-                    double open = entry[U("open")].as_double();
-                    double close = entry[U("close")].as_double();
-                    double high = entry[U("high")].as_double();
-                    double low = entry[U("low")].as_double();
-                    int volume = entry[U("volume")].as_integer();
-
-                    StockData temp(ticker, date, open, close, high, low, volume);
-                    stockTree.insert(temp);
-                }
-                std::cout << "Stock data inserted successfully.\n";
-            }
-            else {
-                std::cout << "No stock data found.\n" << std::endl;
-            }
-        }
-        else {
-            std::cerr << "Error: " << response.status_code() << std::endl;
-        }
-        }).wait();
-}
\ No newline at end of file
+#include "ImportStockData.h"
+#include "DateUtils.h"
+#include "Instrumentation.h"
+#include "SyncState.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+
+bool loadApiConfig(const std::string& filePath, ApiImportConfig& config) {
+    std::ifstream file(filePath);
+    if (!file.is_open()) return false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) continue;
+        std::string name = line.substr(0, eq);
+        std::string value = line.substr(eq + 1);
+        if (name == "API_KEY") config.apiKey = value;
+        else if (name == "API_ENDPOINT") config.endpoint = value;
+        else if (name == "DATE_FROM") config.dateFrom = value;
+        else if (name == "MAX_IN_FLIGHT") config.maxInFlight = std::max(1, std::atoi(value.c_str()));
+        else if (name == "MAX_RETRIES") config.maxRetries = std::max(0, std::atoi(value.c_str()));
+        else if (name == "BACKOFF_MS") config.backoffMs = std::max(0, std::atoi(value.c_str()));
+        else if (name == "TIMEOUT_SECONDS") config.timeoutSeconds = std::max(1, std::atoi(value.c_str()));
+        else if (name == "BATCH_ROWS") config.batchRows = std::max(1, std::atoi(value.c_str()));
+        else if (name == "SYNC_STATE") config.syncStatePath = value;
+    }
+    return !config.apiKey.empty();
+}
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct FetchJob {
+    std::string symbol;
+    std::string dateFrom;
+    int attempt;
+    Clock::time_point due;
+};
+
+struct FetchEvent {
+    FetchJob job;
+    int status = 0;             // 0 when the request never got a response
+    bool ok = false;
+    std::vector<StockData> rows;
+};
+
+bool laterDue(const FetchJob& a, const FetchJob& b) { return a.due > b.due; }
+
+bool retryable(int status) {
+    return status == 0 || status == status_codes::TooManyRequests || status >= 500;
+}
+
+void parseBars(const std::string& ticker, json::value& body, std::vector<StockData>& rows) {
+    auto data = body[U("data")].as_array();
+    rows.reserve(data.size());
+    for (auto& entry : data) {
+        std::string dateTime = utility::conversions::to_utf8string(entry[U("date")].as_string());
+        std::string date = dateTime.substr(0, dateTime.find('T')); // Extract only YYYY-MM-DD
+
+        double open = entry[U("open")].as_double();
+        double close = entry[U("close")].as_double();
+        double high = entry[U("high")].as_double();
+        double low = entry[U("low")].as_double();
+        long volume = static_cast<long>(entry[U("volume")].as_number().to_int64());
+
+        rows.push_back(StockData(ticker, date, open, close, high, low, volume));
+    }
+}
+
+// One import run. The calling thread schedules requests and inserts;
+// HTTP continuations parse and post their result back through `events`.
+class ImportPipeline {
+public:
+    ImportPipeline(const ApiImportConfig& config, const RowSink& sink);
+    void run(std::deque<FetchJob> fresh, ApiImportResult& result);
+
+private:
+    const ApiImportConfig& config;
+    const RowSink& sink;
+    http_client client;
+    utility::string_t apiKey;
+    std::minstd_rand jitter;
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<FetchEvent> events;
+
+    void launch(const FetchJob& job);
+    void post(FetchEvent&& event);
+    Clock::duration backoff(int attempt);
+};
+
+http_client_config clientConfig(const ApiImportConfig& config) {
+    http_client_config settings;
+    settings.set_timeout(std::chrono::seconds(config.timeoutSeconds));
+    return settings;
+}
+
+ImportPipeline::ImportPipeline(const ApiImportConfig& config, const RowSink& sink)
+    : config(config), sink(sink),
+      client(uri(utility::conversions::to_string_t(config.endpoint)), clientConfig(config)),
+      apiKey(utility::conversions::to_string_t(config.apiKey)),
+      jitter(static_cast<unsigned>(Clock::now().time_since_epoch().count())) {}
+
+void ImportPipeline::launch(const FetchJob& job) {
+    uri_builder query;
+    query.append_query(U("symbols"), utility::conversions::to_string_t(job.symbol));
+    query.append_query(U("api_token"), apiKey);
+    query.append_query(U("date_from"), utility::conversions::to_string_t(job.dateFrom)); // Date to get stocks from onward.
+
+    std::shared_ptr<FetchEvent> event = std::make_shared<FetchEvent>();
+    event->job = job;
+    client.request(methods::GET, query.to_string())
+        .then([event](http_response response) {
+            event->status = response.status_code();
+            if (event->status != status_codes::OK) return pplx::task_from_result(json::value());
+            return response.extract_json();
+        })
+        .then([this, event](pplx::task<json::value> body) {
+            // Transport errors surface here as exceptions from get().
+            try {
+                json::value json = body.get();
+                if (event->status == status_codes::OK) {
+                    parseBars(event->job.symbol, json, event->rows);
+                    event->ok = true;
+                }
+            } catch (const std::exception&) {
+                event->rows.clear();
+            }
+            post(std::move(*event));
+        });
+}
+
+void ImportPipeline::post(FetchEvent&& event) {
+    // Notify under the lock: once run() sees the last event it may return
+    // and destroy this pipeline.
+    std::lock_guard<std::mutex> lock(mutex);
+    events.push_back(std::move(event));
+    ready.notify_one();
+}
+
+Clock::duration ImportPipeline::backoff(int attempt) {
+    long long delay = static_cast<long long>(config.backoffMs) << std::min(attempt, 10);
+    delay = std::min(delay, 30000LL);
+    // Up to 50% jitter keeps throttled symbols from retrying in lockstep.
+    delay += delay > 0 ? static_cast<long long>(jitter() % (delay / 2 + 1)) : 0;
+    return std::chrono::milliseconds(delay);
+}
+
+void ImportPipeline::run(std::deque<FetchJob> fresh, ApiImportResult& result) {
+    Clock::time_point now;
+    std::vector<FetchJob> delayed;      // min-heap on due time
+    std::vector<StockData> batch;
+    size_t inFlight = 0;
+
+    while (!fresh.empty() || !delayed.empty() || inFlight > 0) {
+        now = Clock::now();
+        while (inFlight < config.maxInFlight) {
+            FetchJob job;
+            if (!delayed.empty() && delayed.front().due <= now) {
+                std::pop_heap(delayed.begin(), delayed.end(), laterDue);
+                job = delayed.back();
+                delayed.pop_back();
+            } else if (!fresh.empty()) {
+                job = fresh.front();
+                fresh.pop_front();
+            } else {
+                break;
+            }
+            ++inFlight;
+            ++result.requests;
+            launch(job);
+        }
+
+        std::deque<FetchEvent> done;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            auto arrived = [this] { return !events.empty(); };
+            if (!delayed.empty() && inFlight < config.maxInFlight) {
+                ready.wait_until(lock, delayed.front().due, arrived);
+            } else if (inFlight > 0) {
+                ready.wait(lock, arrived);
+            }
+            done.swap(events);
+        }
+
+        for (auto& event : done) {
+            --inFlight;
+            if (event.ok) {
+                result.rowsFetched += event.rows.size();
+                batch.insert(batch.end(), std::make_move_iterator(event.rows.begin()),
+                             std::make_move_iterator(event.rows.end()));
+            } else if (retryable(event.status) && event.job.attempt < config.maxRetries) {
+                ++result.retries;
+                FetchJob retry = event.job;
+                retry.due = Clock::now() + backoff(retry.attempt);
+                ++retry.attempt;
+                delayed.push_back(retry);
+                std::push_heap(delayed.begin(), delayed.end(), laterDue);
+            } else {
+                result.failed.push_back(event.job.symbol);
+            }
+        }
+
+        // Insert while later responses are still in flight.
+        if (batch.size() >= config.batchRows) {
+            result.rowsInserted += sink(batch);
+            batch.clear();
+        }
+    }
+    if (!batch.empty()) result.rowsInserted += sink(batch);
+}
+
+bool runImport(std::deque<FetchJob> jobs, const ApiImportConfig& config,
+               const RowSink& sink, ApiImportResult& result) {
+    result = ApiImportResult();
+    if (config.apiKey.empty()) {
+        result.error = "no API_KEY configured";
+        return false;
+    }
+    if (!uri::validate(utility::conversions::to_string_t(config.endpoint))) {
+        result.error = "invalid API_ENDPOINT: " + config.endpoint;
+        return false;
+    }
+    MM_PROBE_INGEST(Api, result.rowsFetched);
+    ImportPipeline pipeline(config, sink);
+    pipeline.run(std::move(jobs), result);
+    return result.failed.empty();
+}
+
+} // namespace
+
+bool importSymbols(const std::vector<std::string>& symbols, const ApiImportConfig& config,
+                   const RowSink& sink, ApiImportResult& result) {
+    std::deque<FetchJob> jobs;
+    for (const auto& symbol : symbols) jobs.push_back({symbol, config.dateFrom, 0, Clock::now()});
+    return runImport(std::move(jobs), config, sink, result);
+}
+
+bool importSymbols(AVLTree& stockTree, const std::vector<std::string>& symbols,
+                   const ApiImportConfig& config, ApiImportResult& result) {
+    return importSymbols(symbols, config,
+                         [&stockTree](const std::vector<StockData>& rows) { return stockTree.bulkLoad(rows); },
+                         result);
+}
+
+bool importSymbols(ConcurrentStore& store, const std::vector<std::string>& symbols,
+                   const ApiImportConfig& config, ApiImportResult& result) {
+    // Each batch is published as one version.
+    return importSymbols(symbols, config,
+                         [&store](const std::vector<StockData>& rows) { return store.insertBatch(rows); },
+                         result);
+}
+
+bool syncSymbols(const AVLTree& current, const std::vector<std::string>& symbols,
+                 const ApiImportConfig& config, const RowSink& apply, ApiImportResult& result) {
+    SyncState state;
+    if (!state.load(config.syncStatePath)) {
+        result = ApiImportResult();
+        result.error = "unreadable sync state: " + config.syncStatePath;
+        return false;
+    }
+
+    // Ask only for bars after the newer of the stored rows and the mark.
+    std::unordered_map<std::string, int> after;
+    std::deque<FetchJob> jobs;
+    for (const auto& symbol : symbols) {
+        int day, saved;
+        bool known = current.latestDay(symbol, day);
+        if (state.get(symbol, saved) && (!known || saved > day)) {
+            day = saved;
+            known = true;
+        }
+        if (known) after[symbol] = day;
+        jobs.push_back({symbol, known ? DateUtils::toDateString(day + 1) : config.dateFrom, 0, Clock::now()});
+    }
+
+    // Collect everything first so the delta lands as one batch.
+    std::vector<StockData> delta;
+    RowSink collect = [&delta, &after](const std::vector<StockData>& rows) {
+        for (const auto& row : rows) {
+            int day;
+            if (!DateUtils::parseDate(row.date, day)) continue;
+            auto mark = after.find(row.ticker);
+            if (mark == after.end() || day > mark->second) delta.push_back(row);
+        }
+        return rows.size();
+    };
+    ApiImportConfig fetchConfig = config;
+    fetchConfig.batchRows = std::numeric_limits<size_t>::max();
+    bool ok = runImport(std::move(jobs), fetchConfig, collect, result);
+    if (!result.error.empty()) return false;
+
+    result.rowsInserted = delta.empty() ? 0 : apply(delta);
+    for (const auto& row : delta) {
+        int day;
+        DateUtils::parseDate(row.date, day);
+        state.advance(row.ticker, day);
+    }
+    if (!delta.empty() && !state.save(config.syncStatePath)) {
+        result.error = "could not write sync state: " + config.syncStatePath;
+        return false;
+    }
+    return ok;
+}
+
+bool syncSymbols(AVLTree& stockTree, const std::vector<std::string>& symbols,
+                 const ApiImportConfig& config, ApiImportResult& result) {
+    return syncSymbols(stockTree, symbols, config,
+                       [&stockTree](const std::vector<StockData>& rows) { return stockTree.bulkLoad(rows); },
+                       result);
+}
+
+bool syncSymbols(ConcurrentStore& store, const std::vector<std::string>& symbols,
+                 const ApiImportConfig& config, ApiImportResult& result) {
+    std::shared_ptr<const AVLTree> current = store.snapshot();
+    return syncSymbols(*current, symbols, config,
+                       [&store](const std::vector<StockData>& rows) { return store.insertBatch(rows); },
+                       result);
+}
+
+void reportImport(const ApiImportResult& result, bool incremental) {
+    if (!result.error.empty()) {
+        std::cerr << "Error: " << result.error << std::endl;
+        return;
+    }
+    if (incremental && result.failed.empty() && result.rowsInserted == 0) {
+        std::cout << "Already up to date.\n";
+        return;
+    }
+    for (const auto& symbol : result.failed) {
+        std::cerr << "Error: could not fetch " << symbol << std::endl;
+    }
+    if (result.rowsFetched > 0) {
+        std::cout << "Stock data inserted successfully (" << result.rowsInserted << " new rows, "
+                  << result.requests << " requests, " << result.retries << " retries).\n";
+    }
+    else {
+        std::cout << "No stock data found.\n" << std::endl;
+    }
+}
+
+ImportJob::ImportJob() : done(false), incremental(false) {}
+
+ImportJob::~ImportJob() {
+    wait();
+}
+
+bool ImportJob::start(ConcurrentStore& store, const std::vector<std::string>& symbols,
+                      const ApiImportConfig& config, bool sync) {
+    if (worker.joinable()) return false;    // running, or finished but not collected
+    done = false;
+    incremental = sync;
+    result = ApiImportResult();
+    // The worker gets its own copies; the caller's may go away first.
+    worker = std::thread([this, &store, symbols, config]() {
+        if (incremental) syncSymbols(store, symbols, config, result);
+        else importSymbols(store, symbols, config, result);
+        done = true;
+    });
+    return true;
+}
+
+bool ImportJob::collect(ApiImportResult& out, bool& wasIncremental) {
+    if (!worker.joinable() || !done) return false;
+    worker.join();
+    out = result;
+    wasIncremental = incremental;
+    return true;
+}
+
+void ImportJob::wait() {
+    if (worker.joinable()) worker.join();
+}
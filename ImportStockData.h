@@ -1,14 +1,99 @@
-#pragma once
-
-#include "AVLTree.h"
-#include <cpprest/http_client.h>
-#include <cpprest/filestream.h>
-#include <cpprest/asyncrt_utils.h>
-
-using namespace web;
-using namespace web::http;
-using namespace web::http::client;
-using namespace web::json;
-
-std::string GET_API_KEY(const std::string& filePath);
-void importData(AVLTree& stockTree, std::string ticker);
\ No newline at end of file
+#pragma once
+
+#include "AVLTree.h"
+#include "ConcurrentStore.h"
+#include <cpprest/http_client.h>
+#include <cpprest/filestream.h>
+#include <cpprest/asyncrt_utils.h>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+using namespace web;
+using namespace web::http;
+using namespace web::http::client;
+using namespace web::json;
+
+// Importer settings. config.txt holds KEY=VALUE lines; API_KEY is
+// required, the rest override these defaults. Point API_ENDPOINT at a
+// local mock server to test without the real service.
+struct ApiImportConfig {
+    std::string endpoint = "https://api.stockdata.org/v1/data/eod";  // API_ENDPOINT
+    std::string apiKey;                                              // API_KEY
+    std::string dateFrom = "2025-01-01";                             // DATE_FROM
+    size_t maxInFlight = 16;        // MAX_IN_FLIGHT: concurrent requests
+    int maxRetries = 4;             // MAX_RETRIES: per symbol, after the first attempt
+    int backoffMs = 250;            // BACKOFF_MS: first retry delay, doubled each time
+    int timeoutSeconds = 30;        // TIMEOUT_SECONDS: per request
+    size_t batchRows = 50000;       // BATCH_ROWS: rows per store insert
+    std::string syncStatePath = "sync_state.txt";                    // SYNC_STATE
+};
+
+struct ApiImportResult {
+    size_t requests = 0;            // including retries
+    size_t retries = 0;
+    size_t rowsFetched = 0;
+    size_t rowsInserted = 0;
+    std::vector<std::string> failed;
+    std::string error;              // set when the import could not start
+};
+
+// Receives parsed rows in batches and returns how many were added.
+typedef std::function<size_t(const std::vector<StockData>&)> RowSink;
+
+bool loadApiConfig(const std::string& filePath, ApiImportConfig& config);
+
+// Fetches every symbol with at most config.maxInFlight requests
+// outstanding. Responses are parsed on the HTTP client's threads while
+// the calling thread hands finished rows to the sink in batches, so
+// fetching, parsing and inserting overlap. Throttled (429), server (5xx)
+// and transport failures are retried with exponential backoff. Returns
+// false if any symbol still failed; the rest are imported regardless.
+bool importSymbols(const std::vector<std::string>& symbols, const ApiImportConfig& config,
+                   const RowSink& sink, ApiImportResult& result);
+bool importSymbols(AVLTree& stockTree, const std::vector<std::string>& symbols,
+                   const ApiImportConfig& config, ApiImportResult& result);
+bool importSymbols(ConcurrentStore& store, const std::vector<std::string>& symbols,
+                   const ApiImportConfig& config, ApiImportResult& result);
+
+// Incremental sync: requests only bars newer than both the latest row
+// stored for each ticker and its high-water mark in config.syncStatePath,
+// applies the delta as one batch, then advances and saves the marks.
+// `current` is only read; `apply` receives the delta.
+bool syncSymbols(const AVLTree& current, const std::vector<std::string>& symbols,
+                 const ApiImportConfig& config, const RowSink& apply, ApiImportResult& result);
+bool syncSymbols(AVLTree& stockTree, const std::vector<std::string>& symbols,
+                 const ApiImportConfig& config, ApiImportResult& result);
+bool syncSymbols(ConcurrentStore& store, const std::vector<std::string>& symbols,
+                 const ApiImportConfig& config, ApiImportResult& result);
+
+// Prints a finished import or sync's outcome for the menu.
+void reportImport(const ApiImportResult& result, bool incremental);
+
+// Runs one import (or incremental sync) into a ConcurrentStore on its own
+// thread. Each fetched batch is published as one version, so readers keep
+// querying, and see rows arrive, while the fetch is still running. The
+// thread that starts a job polls collect() for its outcome; a job must be
+// collected before the next one can start.
+class ImportJob {
+private:
+    std::thread worker;
+    std::atomic<bool> done;
+    bool incremental;
+    ApiImportResult result;     // owned by the worker until done
+
+public:
+    ImportJob();
+    ~ImportJob();               // waits for a running job
+    ImportJob(const ImportJob&) = delete;
+    ImportJob& operator=(const ImportJob&) = delete;
+
+    // False while an earlier job is running or uncollected. `store` must
+    // outlive the job.
+    bool start(ConcurrentStore& store, const std::vector<std::string>& symbols,
+               const ApiImportConfig& config, bool incremental);
+    bool running() const { return worker.joinable() && !done; }
+    // Once the job has finished: joins it and hands back its outcome.
+    bool collect(ApiImportResult& out, bool& wasIncremental);
+    void wait();
+};
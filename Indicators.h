@@ -0,0 +1,148 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <limits>
+
+// Streaming indicator engine: every indicator keeps O(1) running state,
+// so a whole per-date series is produced in one pass over the closes.
+// Dates before an indicator has enough history get NO_VALUE (NaN).
+namespace Indicators {
+    const double NO_VALUE = std::numeric_limits<double>::quiet_NaN();
+
+    inline bool hasValue(double v) { return !std::isnan(v); }
+    inline double valueOr(double v, double fallback) { return hasValue(v) ? v : fallback; }
+
+    // Mean and population variance of the last `period` values. Welford's
+    // update with removal keeps it stable without re-summing the window.
+    class RollingStats {
+    private:
+        std::vector<double> ring;
+        size_t head;
+        size_t count;
+        double runningMean;
+        double m2;
+
+    public:
+        explicit RollingStats(int period)
+            : ring(period > 0 ? period : 1), head(0), count(0), runningMean(0), m2(0) {}
+
+        void push(double x) {
+            if (count < ring.size()) {
+                count++;
+                double delta = x - runningMean;
+                runningMean += delta / count;
+                m2 += delta * (x - runningMean);
+            } else {
+                double old = ring[head];
+                double oldMean = runningMean;
+                runningMean += (x - old) / count;
+                m2 += (x - old) * (x - runningMean + old - oldMean);
+                if (m2 < 0) m2 = 0;
+            }
+            ring[head] = x;
+            head = (head + 1) % ring.size();
+        }
+
+        bool full() const { return count == ring.size(); }
+        double mean() const { return full() ? runningMean : NO_VALUE; }
+        double variance() const { return full() ? m2 / count : NO_VALUE; }
+        double stddev() const { return full() ? std::sqrt(m2 / count) : NO_VALUE; }
+    };
+
+    // EMA seeded with the SMA of the first `period` values, matching
+    // FinancialMetrics::calculateEMA.
+    class EmaState {
+    private:
+        int period;
+        int seen;
+        double multiplier;
+        double value;
+
+    public:
+        explicit EmaState(int p) : period(p > 0 ? p : 1), seen(0), multiplier(2.0 / (period + 1)), value(0) {}
+
+        double push(double x) {
+            if (seen < period) {
+                value += x;
+                if (++seen < period) return NO_VALUE;
+                value /= period;
+                return value;
+            }
+            value = (x * multiplier) + value * (1 - multiplier);
+            return value;
+        }
+    };
+
+    struct IndicatorConfig {
+        int smaPeriod = 20;
+        int emaPeriod = 50;
+        int volatilityPeriod = 20;
+    };
+
+    struct IndicatorPoint {
+        double sma;
+        double ema;
+        double stddev;      // rolling population std dev of closes
+        double ret;         // simple return vs previous close (fraction)
+        double logRet;
+    };
+
+    class IndicatorStream {
+    private:
+        RollingStats smaWindow;
+        RollingStats volWindow;
+        EmaState ema;
+        double prevClose;
+
+    public:
+        explicit IndicatorStream(const IndicatorConfig& config = IndicatorConfig())
+            : smaWindow(config.smaPeriod), volWindow(config.volatilityPeriod),
+              ema(config.emaPeriod), prevClose(NO_VALUE) {}
+
+        IndicatorPoint push(double close) {
+            smaWindow.push(close);
+            volWindow.push(close);
+            IndicatorPoint p;
+            p.sma = smaWindow.mean();
+            p.ema = ema.push(close);
+            p.stddev = volWindow.stddev();
+            p.ret = hasValue(prevClose) ? close / prevClose - 1 : NO_VALUE;
+            p.logRet = hasValue(prevClose) ? std::log(close / prevClose) : NO_VALUE;
+            prevClose = close;
+            return p;
+        }
+    };
+
+    struct IndicatorSeries {
+        std::vector<double> sma;
+        std::vector<double> ema;
+        std::vector<double> stddev;
+        std::vector<double> returns;
+        std::vector<double> logReturns;
+    };
+
+    inline IndicatorSeries computeSeries(const double* closes, size_t n,
+                                         const IndicatorConfig& config = IndicatorConfig()) {
+        IndicatorSeries series;
+        series.sma.resize(n);
+        series.ema.resize(n);
+        series.stddev.resize(n);
+        series.returns.resize(n);
+        series.logReturns.resize(n);
+        IndicatorStream stream(config);
+        for (size_t i = 0; i < n; i++) {
+            IndicatorPoint p = stream.push(closes[i]);
+            series.sma[i] = p.sma;
+            series.ema[i] = p.ema;
+            series.stddev[i] = p.stddev;
+            series.returns[i] = p.ret;
+            series.logReturns[i] = p.logRet;
+        }
+        return series;
+    }
+
+    inline IndicatorSeries computeSeries(const std::vector<double>& closes,
+                                         const IndicatorConfig& config = IndicatorConfig()) {
+        return computeSeries(closes.data(), closes.size(), config);
+    }
+}
@@ -0,0 +1,291 @@
+#include "Instrumentation.h"
+#include "AVLTree.h"
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Instrumentation {
+
+namespace {
+    const char* const OP_NAMES[OP_COUNT] = { "insert", "search", "update", "remove", "scan", "bulk_load", "aggregate" };
+    const char* const SOURCE_NAMES[SOURCE_COUNT] = { "csv", "api" };
+
+#ifndef MM_NO_INSTRUMENTATION
+    // Written only by its own thread, read by collect(); relaxed atomics
+    // keep the reads well-defined without costing the writer a lock.
+    // Cache-line aligned (C++17 new honours it) so no two threads'
+    // blocks share a line.
+    struct alignas(64) ThreadBlock {
+        std::atomic<uint64_t> calls[OP_COUNT];
+        std::atomic<uint64_t> comparisons[OP_COUNT];
+        std::atomic<uint64_t> rotations[OP_COUNT];
+        std::atomic<uint64_t> nanos[OP_COUNT];
+        std::atomic<uint64_t> buckets[OP_COUNT][LATENCY_BUCKETS];
+        std::atomic<uint64_t> ingestRows[SOURCE_COUNT];
+        std::atomic<uint64_t> ingestNanos[SOURCE_COUNT];
+    };
+
+    void bump(std::atomic<uint64_t>& counter, uint64_t n) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    void readBlock(const ThreadBlock& block, Totals& into) {
+        for (int o = 0; o < OP_COUNT; o++) {
+            OpTotals& t = into.ops[o];
+            t.calls += block.calls[o].load(std::memory_order_relaxed);
+            t.comparisons += block.comparisons[o].load(std::memory_order_relaxed);
+            t.rotations += block.rotations[o].load(std::memory_order_relaxed);
+            t.nanos += block.nanos[o].load(std::memory_order_relaxed);
+            for (int k = 0; k < LATENCY_BUCKETS; k++)
+                t.buckets[k] += block.buckets[o][k].load(std::memory_order_relaxed);
+        }
+        for (int s = 0; s < SOURCE_COUNT; s++) {
+            into.ingest[s].rows += block.ingestRows[s].load(std::memory_order_relaxed);
+            into.ingest[s].nanos += block.ingestNanos[s].load(std::memory_order_relaxed);
+        }
+    }
+
+    // Live per-thread blocks, plus the totals of threads that have exited
+    // and the baseline subtracted by reset().
+    struct Registry {
+        std::mutex mutex;
+        std::vector<ThreadBlock*> blocks;
+        Totals exited;
+        Totals baseline;
+    };
+
+    Registry& registry() {
+        static Registry* instance = new Registry();     // outlives thread_local holders
+        return *instance;
+    }
+
+    struct BlockHolder {
+        ThreadBlock* block;
+
+        BlockHolder() : block(new ThreadBlock()) {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.blocks.push_back(block);
+        }
+        ~BlockHolder() {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            readBlock(*block, r.exited);
+            for (size_t i = 0; i < r.blocks.size(); i++) {
+                if (r.blocks[i] == block) {
+                    r.blocks[i] = r.blocks.back();
+                    r.blocks.pop_back();
+                    break;
+                }
+            }
+            delete block;
+        }
+    };
+
+    ThreadBlock& local() {
+        static thread_local BlockHolder holder;
+        return *holder.block;
+    }
+
+    int bucketFor(uint64_t nanos) {
+        int b = 0;
+        while (nanos) {
+            b++;
+            nanos >>= 1;
+        }
+        return b < LATENCY_BUCKETS ? b : LATENCY_BUCKETS - 1;
+    }
+
+    void subtractTotals(Totals& from, const Totals& base) {
+        for (int o = 0; o < OP_COUNT; o++) {
+            OpTotals& a = from.ops[o];
+            const OpTotals& b = base.ops[o];
+            a.calls -= b.calls;
+            a.comparisons -= b.comparisons;
+            a.rotations -= b.rotations;
+            a.nanos -= b.nanos;
+            for (int k = 0; k < LATENCY_BUCKETS; k++) a.buckets[k] -= b.buckets[k];
+        }
+        for (int s = 0; s < SOURCE_COUNT; s++) {
+            from.ingest[s].rows -= base.ingest[s].rows;
+            from.ingest[s].nanos -= base.ingest[s].nanos;
+        }
+    }
+
+    Totals rawTotals(Registry& r) {
+        Totals totals = r.exited;
+        for (const ThreadBlock* block : r.blocks) readBlock(*block, totals);
+        return totals;
+    }
+#endif
+
+    double perCall(uint64_t value, uint64_t calls) {
+        return calls ? static_cast<double>(value) / calls : 0.0;
+    }
+
+    double ingestRate(const IngestTotals& t) {
+        return t.nanos ? t.rows / (t.nanos * 1e-9) : 0.0;
+    }
+
+    std::string number(double v) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.6g", v);
+        return buf;
+    }
+}
+
+double OpTotals::percentileNanos(double p) const {
+    uint64_t total = 0;
+    for (int k = 0; k < LATENCY_BUCKETS; k++) total += buckets[k];
+    if (total == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * total + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (int k = 0; k < LATENCY_BUCKETS; k++) {
+        seen += buckets[k];
+        if (seen >= rank) return static_cast<double>(1ull << k);
+    }
+    return static_cast<double>(1ull << (LATENCY_BUCKETS - 1));
+}
+
+const char* opName(Op op) {
+    return OP_NAMES[static_cast<int>(op)];
+}
+
+const char* sourceName(Source source) {
+    return SOURCE_NAMES[static_cast<int>(source)];
+}
+
+#ifndef MM_NO_INSTRUMENTATION
+bool enabled() {
+    return true;
+}
+
+void recordOp(Op op, uint64_t nanos, uint64_t comparisons, uint64_t rotations) {
+    ThreadBlock& block = local();
+    int o = static_cast<int>(op);
+    bump(block.calls[o], 1);
+    bump(block.comparisons[o], comparisons);
+    bump(block.rotations[o], rotations);
+    bump(block.nanos[o], nanos);
+    bump(block.buckets[o][bucketFor(nanos)], 1);
+}
+
+void recordIngest(Source source, uint64_t rows, uint64_t nanos) {
+    ThreadBlock& block = local();
+    bump(block.ingestRows[static_cast<int>(source)], rows);
+    bump(block.ingestNanos[static_cast<int>(source)], nanos);
+}
+
+Totals collect() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    Totals totals = rawTotals(r);
+    subtractTotals(totals, r.baseline);
+    return totals;
+}
+
+void reset() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.baseline = rawTotals(r);
+}
+#else
+bool enabled() {
+    return false;
+}
+
+Totals collect() {
+    return Totals();
+}
+
+void reset() {}
+#endif
+
+void writeJson(std::ostream& out, const AVLTree* tree) {
+    Totals totals = collect();
+    out << "{\n  \"enabled\": " << (enabled() ? "true" : "false");
+    if (tree) {
+        SlabStats memory = tree->memoryStats();
+        out << ",\n  \"tree\": {\"nodes\": " << tree->size() << ", \"height\": " << tree->height()
+            << ", \"bytes_allocated\": " << memory.bytesReserved
+            << ", \"bytes_per_node\": " << number(perCall(memory.bytesReserved, tree->size())) << "}";
+    }
+    out << ",\n  \"ingest\": {";
+    for (int s = 0; s < SOURCE_COUNT; s++) {
+        const IngestTotals& t = totals.ingest[s];
+        out << (s ? ", " : "") << "\"" << SOURCE_NAMES[s] << "\": {\"rows\": " << t.rows
+            << ", \"seconds\": " << number(t.nanos * 1e-9) << ", \"rows_per_sec\": " << number(ingestRate(t)) << "}";
+    }
+    out << "},\n  \"operations\": {";
+    for (int o = 0; o < OP_COUNT; o++) {
+        const OpTotals& t = totals.ops[o];
+        out << (o ? "," : "") << "\n    \"" << OP_NAMES[o] << "\": {\"calls\": " << t.calls
+            << ", \"comparisons\": " << t.comparisons
+            << ", \"comparisons_per_call\": " << number(perCall(t.comparisons, t.calls))
+            << ", \"rotations\": " << t.rotations
+            << ", \"mean_ns\": " << number(perCall(t.nanos, t.calls))
+            << ", \"p50_ns\": " << number(t.percentileNanos(50))
+            << ", \"p99_ns\": " << number(t.percentileNanos(99))
+            << ", \"latency_ns_buckets\": [";
+        bool first = true;
+        for (int k = 0; k < LATENCY_BUCKETS; k++) {
+            if (!t.buckets[k]) continue;
+            out << (first ? "" : ", ") << "[" << (1ull << k) << ", " << t.buckets[k] << "]";
+            first = false;
+        }
+        out << "]}";
+    }
+    out << "\n  }\n}\n";
+}
+
+void writePrometheus(std::ostream& out, const AVLTree* tree) {
+    Totals totals = collect();
+    if (tree) {
+        out << "# HELP mm_tree_nodes Rows stored in the tree.\n# TYPE mm_tree_nodes gauge\n"
+            << "mm_tree_nodes " << tree->size() << "\n";
+        out << "# HELP mm_tree_height Height of the AVL tree.\n# TYPE mm_tree_height gauge\n"
+            << "mm_tree_height " << tree->height() << "\n";
+        out << "# HELP mm_tree_bytes_allocated Bytes reserved by the node allocator.\n"
+            << "# TYPE mm_tree_bytes_allocated gauge\n"
+            << "mm_tree_bytes_allocated " << tree->memoryStats().bytesReserved << "\n";
+    }
+    if (!enabled()) return;
+
+    out << "# HELP mm_operations_total Tree operations performed.\n# TYPE mm_operations_total counter\n";
+    for (int o = 0; o < OP_COUNT; o++)
+        out << "mm_operations_total{op=\"" << OP_NAMES[o] << "\"} " << totals.ops[o].calls << "\n";
+    out << "# HELP mm_key_comparisons_total Key comparisons made by tree operations.\n"
+        << "# TYPE mm_key_comparisons_total counter\n";
+    for (int o = 0; o < OP_COUNT; o++)
+        out << "mm_key_comparisons_total{op=\"" << OP_NAMES[o] << "\"} " << totals.ops[o].comparisons << "\n";
+    out << "# HELP mm_rotations_total AVL rotations made while rebalancing.\n# TYPE mm_rotations_total counter\n";
+    for (int o = 0; o < OP_COUNT; o++)
+        out << "mm_rotations_total{op=\"" << OP_NAMES[o] << "\"} " << totals.ops[o].rotations << "\n";
+
+    out << "# HELP mm_operation_latency_seconds Latency of tree operations.\n"
+        << "# TYPE mm_operation_latency_seconds histogram\n";
+    for (int o = 0; o < OP_COUNT; o++) {
+        const OpTotals& t = totals.ops[o];
+        uint64_t cumulative = 0;
+        for (int k = 0; k < LATENCY_BUCKETS - 1; k++) {
+            cumulative += t.buckets[k];
+            out << "mm_operation_latency_seconds_bucket{op=\"" << OP_NAMES[o] << "\",le=\""
+                << number((1ull << k) * 1e-9) << "\"} " << cumulative << "\n";
+        }
+        out << "mm_operation_latency_seconds_bucket{op=\"" << OP_NAMES[o] << "\",le=\"+Inf\"} " << t.calls << "\n";
+        out << "mm_operation_latency_seconds_sum{op=\"" << OP_NAMES[o] << "\"} " << number(t.nanos * 1e-9) << "\n";
+        out << "mm_operation_latency_seconds_count{op=\"" << OP_NAMES[o] << "\"} " << t.calls << "\n";
+    }
+
+    out << "# HELP mm_ingest_rows_total Rows read by imports.\n# TYPE mm_ingest_rows_total counter\n";
+    for (int s = 0; s < SOURCE_COUNT; s++)
+        out << "mm_ingest_rows_total{source=\"" << SOURCE_NAMES[s] << "\"} " << totals.ingest[s].rows << "\n";
+    out << "# HELP mm_ingest_seconds_total Time spent in imports.\n# TYPE mm_ingest_seconds_total counter\n";
+    for (int s = 0; s < SOURCE_COUNT; s++)
+        out << "mm_ingest_seconds_total{source=\"" << SOURCE_NAMES[s] << "\"} "
+            << number(totals.ingest[s].nanos * 1e-9) << "\n";
+}
+
+}
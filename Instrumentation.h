@@ -0,0 +1,129 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+class AVLTree;
+
+// Counters and latency histograms for the store's hot paths. Define
+// MM_NO_INSTRUMENTATION to compile every probe out; the dump functions
+// then report only what the tree itself knows (node count, height,
+// memory).
+//
+// Probes are cheap: per-comparison and per-rotation counts bump plain
+// thread-local integers, and each operation folds its deltas and
+// latency into its thread's block with relaxed atomics, once. Threads
+// never share a cache line on the hot path; dumps sum every block.
+namespace Instrumentation {
+    enum class Op { Insert, Search, Update, Remove, Scan, BulkLoad, Aggregate };
+    const int OP_COUNT = 7;
+
+    enum class Source { Csv, Api };
+    const int SOURCE_COUNT = 2;
+
+    // Bucket b counts latencies below 2^b ns (and at least 2^(b-1));
+    // the last bucket also takes everything slower.
+    const int LATENCY_BUCKETS = 40;
+
+    struct OpTotals {
+        uint64_t calls = 0;
+        uint64_t comparisons = 0;
+        uint64_t rotations = 0;
+        uint64_t nanos = 0;
+        uint64_t buckets[LATENCY_BUCKETS] = {};
+
+        double percentileNanos(double p) const;     // bucket upper bound, p in [0, 100]
+    };
+
+    struct IngestTotals {
+        uint64_t rows = 0;
+        uint64_t nanos = 0;
+    };
+
+    struct Totals {
+        OpTotals ops[OP_COUNT];
+        IngestTotals ingest[SOURCE_COUNT];
+    };
+
+    const char* opName(Op op);
+    const char* sourceName(Source source);
+
+    bool enabled();
+    Totals collect();
+    void reset();
+
+    // Adds the tree's node count, height and allocator usage when given.
+    void writeJson(std::ostream& out, const AVLTree* tree);
+    void writePrometheus(std::ostream& out, const AVLTree* tree);
+
+#ifndef MM_NO_INSTRUMENTATION
+    struct Pending {
+        uint64_t comparisons;
+        uint64_t rotations;
+    };
+    inline thread_local Pending pending = {};
+
+    void recordOp(Op op, uint64_t nanos, uint64_t comparisons, uint64_t rotations);
+    void recordIngest(Source source, uint64_t rows, uint64_t nanos);
+
+    // Times one operation and attributes the comparisons and rotations
+    // made on this thread meanwhile to it.
+    class ScopedOp {
+    private:
+        Op op;
+        uint64_t comparisons;
+        uint64_t rotations;
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        explicit ScopedOp(Op op)
+            : op(op), comparisons(pending.comparisons), rotations(pending.rotations),
+              start(std::chrono::steady_clock::now()) {}
+        ~ScopedOp() {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            recordOp(op, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()),
+                     pending.comparisons - comparisons, pending.rotations - rotations);
+        }
+        ScopedOp(const ScopedOp&) = delete;
+        ScopedOp& operator=(const ScopedOp&) = delete;
+    };
+
+    // Times an import; rows() is read when the scope ends.
+    template <typename RowCount>
+    class ScopedIngest {
+    private:
+        Source source;
+        RowCount rows;
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        ScopedIngest(Source source, RowCount rows)
+            : source(source), rows(rows), start(std::chrono::steady_clock::now()) {}
+        ~ScopedIngest() {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            recordIngest(source, static_cast<uint64_t>(rows()),
+                         static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
+        ScopedIngest(const ScopedIngest&) = delete;
+        ScopedIngest& operator=(const ScopedIngest&) = delete;
+    };
+#endif
+}
+
+#ifndef MM_NO_INSTRUMENTATION
+#define MM_PROBE_OP(op) Instrumentation::ScopedOp mmProbeOp_(Instrumentation::Op::op)
+#define MM_PROBE_COMPARE() (Instrumentation::pending.comparisons++)
+#define MM_PROBE_ROTATE() (Instrumentation::pending.rotations++)
+#define MM_PROBE_INGEST(source, rows) \
+    Instrumentation::ScopedIngest mmProbeIngest_(Instrumentation::Source::source, [&]() { return (rows); })
+#else
+#define MM_PROBE_OP(op) ((void)0)
+#define MM_PROBE_COMPARE() ((void)0)
+#define MM_PROBE_ROTATE() ((void)0)
+#define MM_PROBE_INGEST(source, rows) ((void)0)
+#endif
+
+#endif
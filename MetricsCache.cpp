@@ -0,0 +1,115 @@
+#include "MetricsCache.h"
+#include "FinancialMetrics.h"
+#include <climits>
+
+MetricsCache::MetricsCache(AVLTree& tree)
+    : source(tree), mutations(0), hits(0), misses(0), invalidations(0) {
+    source.addListener(this);
+}
+
+MetricsCache::MetricsCache(ConcurrentStore& store)
+    : source(store), mutations(0), hits(0), misses(0), invalidations(0) {
+    source.addListener(this);
+}
+
+MetricsCache::~MetricsCache() {
+    source.removeListener(this);
+}
+
+double MetricsCache::sma(const std::string& ticker, int period) {
+    return get(ticker, MetricKind::SMA, period);
+}
+
+double MetricsCache::ema(const std::string& ticker, int period) {
+    return get(ticker, MetricKind::EMA, period);
+}
+
+double MetricsCache::volatility(const std::string& ticker) {
+    return get(ticker, MetricKind::Volatility, 0);
+}
+
+double MetricsCache::get(const std::string& ticker, MetricKind kind, int period) {
+    uint64_t seen;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        seen = mutations;
+        auto it = entries.find(ticker);
+        if (it != entries.end()) {
+            for (const Entry& e : it->second) {
+                if (e.kind == kind && e.period == period) {
+                    hits++;
+                    return e.value;
+                }
+            }
+        }
+    }
+    misses++;
+    // A store notifies only after publishing, so a version pinned after
+    // reading `seen` holds every mutation notified before it; any it
+    // lacks will bump `mutations` before the entry could be stored.
+    std::shared_ptr<const AVLTree> tree = source.pin();
+    Entry entry = compute(*tree, ticker, kind, period);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (mutations != seen) return entry.value;
+    std::vector<Entry>& list = entries[ticker];
+    for (const Entry& e : list)
+        if (e.kind == kind && e.period == period) return e.value;   // another thread won
+    list.push_back(entry);
+    return entry.value;
+}
+
+// Reads the closes the metric needs straight off a tree cursor. SMA only
+// looks at the first `period` rows, so its span stops there.
+MetricsCache::Entry MetricsCache::compute(const AVLTree& tree, const std::string& ticker, MetricKind kind, int period) {
+    Entry entry = { kind, period, 0, INT_MAX, INT_MIN, true };
+    std::vector<double> closes;
+    size_t limit = (kind == MetricKind::SMA && period > 0) ? static_cast<size_t>(period) : SIZE_MAX;
+    for (RangeCursor c = tree.scanTicker(ticker); c.valid() && closes.size() < limit; c.next()) {
+        if (closes.empty()) entry.firstDay = keyDay(c.key());
+        entry.lastDay = keyDay(c.key());
+        closes.push_back(c->closePrice);
+    }
+
+    switch (kind) {
+        case MetricKind::SMA:
+            entry.value = FinancialMetrics::calculateSMA(closes, period);
+            entry.wholeSeries = closes.size() < limit;  // too short: any new row matters
+            break;
+        case MetricKind::EMA:
+            entry.value = FinancialMetrics::calculateEMA(closes, period);
+            break;
+        case MetricKind::Volatility:
+            entry.value = FinancialMetrics::calculateVolatility(closes);
+            break;
+    }
+    return entry;
+}
+
+void MetricsCache::onMutation(const std::string& ticker, int day, MutationKind kind) {
+    std::lock_guard<std::mutex> lock(mutex);
+    mutations++;
+    auto it = entries.find(ticker);
+    if (it == entries.end()) return;
+    std::vector<Entry>& list = it->second;
+    size_t kept = 0;
+    for (size_t i = 0; i < list.size(); i++) {
+        const Entry& e = list[i];
+        bool stale = (kind == MutationKind::Update)
+            ? (day >= e.firstDay && day <= e.lastDay)
+            : (e.wholeSeries || day <= e.lastDay);
+        if (stale) invalidations++;
+        else list[kept++] = e;
+    }
+    list.resize(kept);
+    if (list.empty()) entries.erase(it);
+}
+
+MetricsCacheStats MetricsCache::stats() const {
+    MetricsCacheStats s = { hits.load(), misses.load(), invalidations.load() };
+    return s;
+}
+
+void MetricsCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+}
@@ -0,0 +1,70 @@
+#ifndef METRICSCACHE_H
+#define METRICSCACHE_H
+
+#include "AVLTree.h"
+#include "ConcurrentStore.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class MetricKind { SMA, EMA, Volatility };
+
+struct MetricsCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t invalidations;
+};
+
+// Memoizes FinancialMetrics results per (ticker, metric, period). Each
+// entry remembers the span of dates it was computed from, and the cache
+// listens to the tree so a mutation only drops entries whose inputs it
+// actually changed:
+//   - update at day d: entries whose span contains d
+//   - insert/remove at day d: entries whose span ends at or after d, and
+//     entries that depend on the whole series (EMA, volatility).
+// Lookups are thread-safe. Over a plain tree, concurrent tree mutation is
+// not supported; over a ConcurrentStore, values are computed from the
+// latest snapshot and writers may run at any time.
+class MetricsCache : public TreeListener {
+private:
+    struct Entry {
+        MetricKind kind;
+        int period;
+        double value;
+        int firstDay;
+        int lastDay;
+        bool wholeSeries;
+    };
+
+    TreeSource source;
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, std::vector<Entry>> entries;
+    uint64_t mutations;     // notifications so far; guards against caching from a replaced version
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    std::atomic<uint64_t> invalidations;
+
+    double get(const std::string& ticker, MetricKind kind, int period);
+    static Entry compute(const AVLTree& tree, const std::string& ticker, MetricKind kind, int period);
+
+public:
+    explicit MetricsCache(AVLTree& tree);
+    explicit MetricsCache(ConcurrentStore& store);
+    ~MetricsCache();
+    MetricsCache(const MetricsCache&) = delete;
+    MetricsCache& operator=(const MetricsCache&) = delete;
+
+    double sma(const std::string& ticker, int period);
+    double ema(const std::string& ticker, int period);
+    double volatility(const std::string& ticker);
+
+    MetricsCacheStats stats() const;
+    void clear();
+
+    void onMutation(const std::string& ticker, int day, MutationKind kind) override;
+};
+
+#endif
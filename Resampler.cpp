@@ -0,0 +1,214 @@
+#include "Resampler.h"
+#include "DateUtils.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+    int floorDiv(int a, int b) {
+        int q = a / b;
+        return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+    }
+
+    ResampledBar barFrom(int startDay, const RangeAggregate& a) {
+        ResampledBar bar;
+        bar.startDay = startDay;
+        bar.firstDay = a.firstDay;
+        bar.lastDay = a.lastDay;
+        bar.openPrice = a.firstOpen;
+        bar.closePrice = a.lastClose;
+        bar.highPrice = a.high;
+        bar.lowPrice = a.low;
+        bar.volume = a.volume;
+        bar.rows = a.count;
+        return bar;
+    }
+
+    // Appends the bars of every bucket holding a row in [fromDay, toDay],
+    // skipping empty buckets with one cursor seek each.
+    void appendBars(const AVLTree& tree, const std::string& ticker, const BarPeriod& period,
+                    int fromDay, int toDay, std::vector<ResampledBar>& out) {
+        while (fromDay <= toDay) {
+            RangeCursor c = tree.scanDays(ticker, fromDay, toDay);
+            if (!c.valid()) break;
+            int start = period.bucketStart(c.day());
+            int end = period.bucketEnd(c.day());
+            RangeAggregate a;
+            if (!tree.aggregateDays(ticker, start, end, a) || a.count == 0) break;
+            out.push_back(barFrom(start, a));
+            if (end >= toDay) break;
+            fromDay = end + 1;
+        }
+    }
+
+    bool startsBefore(const ResampledBar& bar, int day) { return bar.startDay < day; }
+}
+
+bool BarPeriod::parse(const std::string& text, BarPeriod& out) {
+    if (text == "week" || text == "weekly" || text == "1w") {
+        out = weekly();
+        return true;
+    }
+    if (text == "month" || text == "monthly" || text == "1m") {
+        out = monthly();
+        return true;
+    }
+    if (text.size() < 2 || text.back() != 'd') return false;
+    char* end = nullptr;
+    long n = strtol(text.c_str(), &end, 10);
+    if (end != text.c_str() + text.size() - 1 || n < 1 || n > 100000) return false;
+    out = everyDays(static_cast<int>(n));
+    return true;
+}
+
+std::string BarPeriod::describe() const {
+    switch (unit) {
+        case BarUnit::Week: return "week";
+        case BarUnit::Month: return "month";
+        case BarUnit::Days: break;
+    }
+    return std::to_string(days) + "d";
+}
+
+int BarPeriod::bucketStart(int day) const {
+    switch (unit) {
+        case BarUnit::Week:
+            return day - (day + 3 - floorDiv(day + 3, 7) * 7);   // day 0 was a Thursday
+        case BarUnit::Month: {
+            int y;
+            unsigned m, d;
+            DateUtils::civilFromDays(day, y, m, d);
+            return day - static_cast<int>(d) + 1;
+        }
+        case BarUnit::Days:
+            break;
+    }
+    return floorDiv(day, days) * days;
+}
+
+int BarPeriod::bucketEnd(int day) const {
+    switch (unit) {
+        case BarUnit::Week:
+            return bucketStart(day) + 6;
+        case BarUnit::Month: {
+            int y;
+            unsigned m, d;
+            DateUtils::civilFromDays(day, y, m, d);
+            return day + static_cast<int>(DateUtils::daysInMonth(y, m) - d);
+        }
+        case BarUnit::Days:
+            break;
+    }
+    return bucketStart(day) + days - 1;
+}
+
+std::vector<ResampledBar> resample(const AVLTree& tree, const std::string& ticker, const BarPeriod& period,
+                                   int startDay, int endDay) {
+    std::vector<ResampledBar> bars;
+    if (startDay != INT_MIN) startDay = period.bucketStart(startDay);
+    if (endDay != INT_MAX) endDay = period.bucketEnd(endDay);
+    appendBars(tree, ticker, period, startDay, endDay, bars);
+    return bars;
+}
+
+ResampleCache::ResampleCache(AVLTree& tree) : source(tree), hits(0), builds(0), rebuiltBars(0) {
+    source.addListener(this);
+}
+
+ResampleCache::ResampleCache(ConcurrentStore& store) : source(store), hits(0), builds(0), rebuiltBars(0) {
+    source.addListener(this);
+}
+
+ResampleCache::~ResampleCache() {
+    source.removeListener(this);
+}
+
+// Recomputes the dirty bars in place, then rebuilds the dirty tail.
+void ResampleCache::repair(const AVLTree& tree, const std::string& ticker, Level& level) {
+    std::vector<ResampledBar>& bars = level.bars;
+    int tailStart = level.dirtyFrom == INT_MAX ? INT_MAX : level.period.bucketStart(level.dirtyFrom);
+
+    std::sort(level.dirtyBuckets.begin(), level.dirtyBuckets.end());
+    level.dirtyBuckets.erase(std::unique(level.dirtyBuckets.begin(), level.dirtyBuckets.end()),
+                             level.dirtyBuckets.end());
+    for (int start : level.dirtyBuckets) {
+        if (start >= tailStart) break;
+        auto it = std::lower_bound(bars.begin(), bars.end(), start, startsBefore);
+        RangeAggregate a;
+        tree.aggregateDays(ticker, start, level.period.bucketEnd(start), a);
+        bool present = it != bars.end() && it->startDay == start;
+        if (a.count == 0) {
+            if (present) bars.erase(it);
+        } else if (present) {
+            *it = barFrom(start, a);
+        } else {
+            bars.insert(it, barFrom(start, a));
+        }
+        rebuiltBars++;
+    }
+    level.dirtyBuckets.clear();
+
+    if (tailStart != INT_MAX) {
+        auto it = std::lower_bound(bars.begin(), bars.end(), tailStart, startsBefore);
+        size_t kept = static_cast<size_t>(it - bars.begin());
+        bars.erase(it, bars.end());
+        appendBars(tree, ticker, level.period, tailStart, INT_MAX, bars);
+        rebuiltBars += bars.size() - kept;
+        level.dirtyFrom = INT_MAX;
+    }
+}
+
+std::vector<ResampledBar> ResampleCache::bars(const std::string& ticker, const BarPeriod& period,
+                                              int startDay, int endDay) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // Pinned under the lock: a store notifies after publishing, so any
+    // mutation this version lacks marks the level dirty once we return.
+    std::shared_ptr<const AVLTree> tree = source.pin();
+    std::vector<Level>& list = levels[ticker];
+    Level* level = nullptr;
+    for (Level& l : list)
+        if (l.period == period) level = &l;
+
+    if (!level) {
+        list.push_back(Level{ period, resample(*tree, ticker, period), {}, INT_MAX });
+        level = &list.back();
+        builds++;
+    } else if (level->dirtyFrom != INT_MAX || !level->dirtyBuckets.empty()) {
+        repair(*tree, ticker, *level);
+    } else {
+        hits++;
+    }
+
+    const std::vector<ResampledBar>& all = level->bars;
+    auto first = startDay == INT_MIN ? all.begin()
+                                     : std::lower_bound(all.begin(), all.end(), period.bucketStart(startDay), startsBefore);
+    auto last = first;
+    while (last != all.end() && last->startDay <= endDay) ++last;
+    return std::vector<ResampledBar>(first, last);
+}
+
+void ResampleCache::onMutation(const std::string& ticker, int day, MutationKind kind) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = levels.find(ticker);
+    if (it == levels.end()) return;
+    for (Level& level : it->second) {
+        if (kind == MutationKind::Insert)
+            level.dirtyFrom = std::min(level.dirtyFrom, day);
+        else
+            level.dirtyBuckets.push_back(level.period.bucketStart(day));
+        // Past this many scattered repairs, one tail rebuild is cheaper
+        if (level.dirtyBuckets.size() > level.bars.size() / 4 + 64) {
+            int earliest = *std::min_element(level.dirtyBuckets.begin(), level.dirtyBuckets.end());
+            level.dirtyFrom = std::min(level.dirtyFrom, earliest);
+            level.dirtyBuckets.clear();
+        }
+    }
+}
+
+ResampleCacheStats ResampleCache::stats() const {
+    return { hits.load(), builds.load(), rebuiltBars.load() };
+}
+
+void ResampleCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    levels.clear();
+}
@@ -0,0 +1,106 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include "AVLTree.h"
+#include "ConcurrentStore.h"
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class BarUnit { Week, Month, Days };
+
+// A bar width. Buckets are calendar-aligned so a bar never depends on
+// where a query starts: weeks run Monday to Sunday, months from the 1st,
+// and N-day bars from day 0 (1970-01-01) in steps of N.
+struct BarPeriod {
+    BarUnit unit = BarUnit::Week;
+    int days = 7;                   // bucket width for BarUnit::Days
+
+    static BarPeriod weekly() { return BarPeriod(); }
+    static BarPeriod monthly() { BarPeriod p; p.unit = BarUnit::Month; p.days = 0; return p; }
+    static BarPeriod everyDays(int n) { BarPeriod p; p.unit = BarUnit::Days; p.days = n; return p; }
+
+    // Accepts "week", "month" or "<N>d" (N >= 1)
+    static bool parse(const std::string& text, BarPeriod& out);
+    std::string describe() const;
+
+    int bucketStart(int day) const;
+    int bucketEnd(int day) const;   // inclusive
+
+    bool operator==(const BarPeriod& other) const { return unit == other.unit && days == other.days; }
+};
+
+struct ResampledBar {
+    int startDay = 0;               // first calendar day of the bucket
+    int firstDay = 0;               // first and last trading days in it
+    int lastDay = 0;
+    double openPrice = 0;
+    double closePrice = 0;
+    double highPrice = 0;
+    double lowPrice = 0;
+    long long volume = 0;
+    uint64_t rows = 0;
+};
+
+// Rolls a ticker's daily rows in [startDay, endDay] up into bars: open of
+// the first row, close of the last, extreme high/low, summed volume.
+// Every bucket overlapping the window is returned whole. Each bar costs one
+// cursor seek and one subtree-aggregate query, so the work is
+// O(bars * log n) however many rows the bars cover.
+std::vector<ResampledBar> resample(const AVLTree& tree, const std::string& ticker, const BarPeriod& period,
+                                   int startDay = INT_MIN, int endDay = INT_MAX);
+
+struct ResampleCacheStats {
+    uint64_t hits;                  // reads served without touching the tree
+    uint64_t builds;                // levels materialized from scratch
+    uint64_t rebuiltBars;           // bars recomputed after mutations
+};
+
+// Materialized coarser levels, one per (ticker, period) that has been
+// asked for. The cache listens to the tree and repairs levels lazily on
+// the next read:
+//   - update/remove at day d: only the bar covering d is recomputed
+//   - insert at day d: bars from d's bucket onward (a bulk load reports
+//     only its earliest day per ticker)
+// Reads are thread-safe. Over a plain tree, concurrent tree mutation is
+// not supported; over a ConcurrentStore, repairs read the latest snapshot
+// and writers may run at any time.
+class ResampleCache : public TreeListener {
+private:
+    struct Level {
+        BarPeriod period;
+        std::vector<ResampledBar> bars;
+        std::vector<int> dirtyBuckets;
+        int dirtyFrom;              // INT_MAX when the tail is clean
+    };
+
+    TreeSource source;
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, std::vector<Level>> levels;
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> builds;
+    std::atomic<uint64_t> rebuiltBars;
+
+    void repair(const AVLTree& tree, const std::string& ticker, Level& level);
+
+public:
+    explicit ResampleCache(AVLTree& tree);
+    explicit ResampleCache(ConcurrentStore& store);
+    ~ResampleCache();
+    ResampleCache(const ResampleCache&) = delete;
+    ResampleCache& operator=(const ResampleCache&) = delete;
+
+    std::vector<ResampledBar> bars(const std::string& ticker, const BarPeriod& period,
+                                   int startDay = INT_MIN, int endDay = INT_MAX);
+
+    ResampleCacheStats stats() const;
+    void clear();
+
+    void onMutation(const std::string& ticker, int day, MutationKind kind) override;
+};
+
+#endif
@@ -0,0 +1,100 @@
+#include "Screener.h"
+#include "FinancialMetrics.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    struct Ranking {
+        bool descending;
+        bool operator()(const ScreenResult& a, const ScreenResult& b) const {     // a ranks ahead of b
+            if (a.value != b.value) return descending ? a.value > b.value : a.value < b.value;
+            return a.ticker < b.ticker;
+        }
+    };
+
+    bool evaluate(const AVLTree& tree, const std::string& ticker, const ScreenQuery& q, ScreenResult& out) {
+        RangeAggregate a;
+        if (!tree.aggregateDays(ticker, q.startDay, q.endDay, a) || a.count < std::max<size_t>(q.minRows, 1))
+            return false;
+        double averageVolume = static_cast<double>(a.volume) / a.count;
+        if (averageVolume < q.minAverageVolume || a.lastClose < q.minLastClose) return false;
+        RangeCursor first = tree.scanDays(ticker, q.startDay, q.endDay);
+
+        out.ticker = ticker;
+        out.firstDay = a.firstDay;
+        out.lastDay = a.lastDay;
+        out.firstClose = first->closePrice;
+        out.lastClose = a.lastClose;
+        out.averageVolume = averageVolume;
+        out.rows = a.count;
+        switch (q.metric) {
+            case ScreenMetric::PercentReturn:
+                if (a.count < 2 || out.firstClose <= 0) return false;
+                out.value = FinancialMetrics::percentageReturn(out.firstClose, a.lastClose);
+                break;
+            case ScreenMetric::PriceChange:
+                out.value = FinancialMetrics::dailyPriceChange(a.firstOpen, a.lastClose);
+                break;
+            case ScreenMetric::Volatility:
+                out.value = std::sqrt(a.closeVariance());
+                break;
+            case ScreenMetric::AverageVolume:
+                out.value = averageVolume;
+                break;
+        }
+        return !std::isnan(out.value);
+    }
+
+    // Bounded heap with the weakest kept result at the front.
+    void offer(std::vector<ScreenResult>& heap, ScreenResult& candidate, size_t limit, const Ranking& rank) {
+        if (heap.size() < limit) {
+            heap.push_back(std::move(candidate));
+            std::push_heap(heap.begin(), heap.end(), rank);
+        } else if (rank(candidate, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), rank);
+            heap.back() = std::move(candidate);
+            std::push_heap(heap.begin(), heap.end(), rank);
+        }
+    }
+}
+
+bool parseScreenMetric(const std::string& name, ScreenMetric& out) {
+    if (name == "return") out = ScreenMetric::PercentReturn;
+    else if (name == "change") out = ScreenMetric::PriceChange;
+    else if (name == "volatility") out = ScreenMetric::Volatility;
+    else if (name == "volume") out = ScreenMetric::AverageVolume;
+    else return false;
+    return true;
+}
+
+const char* screenMetricName(ScreenMetric metric) {
+    switch (metric) {
+        case ScreenMetric::PercentReturn: return "return";
+        case ScreenMetric::PriceChange: return "change";
+        case ScreenMetric::Volatility: return "volatility";
+        case ScreenMetric::AverageVolume: return "volume";
+    }
+    return "";
+}
+
+std::vector<ScreenResult> runScreen(const AVLTree& tree, const ScreenQuery& query, ThreadPool& pool) {
+    std::vector<ScreenResult> results;
+    if (query.limit == 0 || query.startDay > query.endDay) return results;
+    const Ranking rank = { query.descending };
+    const std::vector<std::string> tickers = tree.getTickers();
+    const size_t chunks = std::max<size_t>(1, std::min<size_t>(tickers.size(), 4 * (pool.size() + 1)));
+    const size_t perChunk = (tickers.size() + chunks - 1) / chunks;
+
+    std::vector<std::vector<ScreenResult>> heaps(chunks);
+    pool.parallelFor(chunks, [&](size_t c) {
+        std::vector<ScreenResult>& heap = heaps[c];
+        ScreenResult candidate;
+        for (size_t i = c * perChunk; i < std::min(tickers.size(), (c + 1) * perChunk); i++)
+            if (evaluate(tree, tickers[i], query, candidate)) offer(heap, candidate, query.limit, rank);
+    });
+
+    for (std::vector<ScreenResult>& heap : heaps)
+        for (ScreenResult& r : heap) offer(results, r, query.limit, rank);
+    std::sort(results.begin(), results.end(), rank);
+    return results;
+}
@@ -0,0 +1,51 @@
+#ifndef SCREENER_H
+#define SCREENER_H
+
+#include "AVLTree.h"
+#include "ThreadPool.h"
+#include <climits>
+#include <string>
+#include <vector>
+
+// What a screen ranks tickers by, over the rows in [startDay, endDay]:
+//   PercentReturn   first close to last close, percent
+//   PriceChange     last close minus first open
+//   Volatility      std dev of closes (as FinancialMetrics::calculateVolatility)
+//   AverageVolume   mean daily volume
+enum class ScreenMetric { PercentReturn, PriceChange, Volatility, AverageVolume };
+
+bool parseScreenMetric(const std::string& name, ScreenMetric& out);     // "return", "change", "volatility", "volume"
+const char* screenMetricName(ScreenMetric metric);
+
+struct ScreenQuery {
+    ScreenMetric metric = ScreenMetric::PercentReturn;
+    bool descending = true;         // top K; false for bottom K
+    size_t limit = 20;
+    int startDay = INT_MIN;
+    int endDay = INT_MAX;
+    // Filters: tickers failing any of them are skipped
+    double minAverageVolume = 0;
+    double minLastClose = 0;
+    size_t minRows = 1;
+};
+
+struct ScreenResult {
+    std::string ticker;
+    double value;
+    int firstDay;
+    int lastDay;
+    double firstClose;
+    double lastClose;
+    double averageVolume;
+    size_t rows;
+};
+
+// Ranks every ticker in the tree. Each ticker costs two O(log n) tree
+// queries (its range aggregate and first row), whatever the window's
+// length. Tickers are split into chunks across the pool; each chunk keeps
+// a bounded heap of its best `limit` results and the heaps are merged at
+// the end. Ties rank by ticker name, so results do not depend on the
+// pool size. The tree must not be mutated while this runs.
+std::vector<ScreenResult> runScreen(const AVLTree& tree, const ScreenQuery& query, ThreadPool& pool);
+
+#endif
@@ -0,0 +1,184 @@
+#include "SelfTest.h"
+#include "ConcurrentStore.h"
+#include "DateUtils.h"
+#include "MetricsCache.h"
+#include <atomic>
+#include <climits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int TICKERS = 16;
+const int STEPS = 600;          // batches the writer publishes
+const int READERS = 3;
+const int FIRST_DAY = 18262;    // 2020-01-01
+
+std::string tickerName(int i) {
+    return std::string("T") + static_cast<char>('A' + i / 10) + static_cast<char>('0' + i % 10);
+}
+
+// Collects the first failure; later ones are only counted.
+struct Failures {
+    std::mutex mutex;
+    std::atomic<int> count{ 0 };
+    std::string first;
+
+    void report(const std::string& what) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (count++ == 0) first = what;
+    }
+};
+
+// Order-dependent hash of every row, for telling whether a version changed.
+uint64_t checksum(const AVLTree& tree) {
+    uint64_t hash = 1469598103934665603ull;
+    for (RangeCursor c = tree.scanAll(); c.valid(); c.next()) {
+        hash = (hash ^ c.key()) * 1099511628211ull;
+        hash = (hash ^ static_cast<uint64_t>(c->volume)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// Every batch adds, updates and removes the same days for every ticker,
+// so within one version all tickers hold the same days and volumes.
+bool checkVersion(const AVLTree& tree, Failures& failures) {
+    std::vector<int> days;
+    std::vector<long> volumes;
+    size_t walked = 0;
+    for (int t = 0; t < TICKERS; t++) {
+        std::string ticker = tickerName(t);
+        size_t rows = 0;
+        long long volume = 0;
+        for (RangeCursor c = tree.scanTicker(ticker); c.valid(); c.next(), rows++) {
+            volume += c->volume;
+            if (t == 0) {
+                days.push_back(c.day());
+                volumes.push_back(c->volume);
+            } else if (rows >= days.size() || days[rows] != c.day() || volumes[rows] != c->volume) {
+                failures.report(ticker + " differs from " + tickerName(0) + " within one version (torn batch)");
+                return false;
+            }
+        }
+        if (rows != days.size()) {
+            failures.report(ticker + " has " + std::to_string(rows) + " rows, " + tickerName(0) +
+                            " has " + std::to_string(days.size()) + " (torn batch)");
+            return false;
+        }
+        RangeAggregate summary;
+        bool found = tree.aggregateDays(ticker, INT_MIN, INT_MAX, summary);
+        if (found != (rows > 0) || (found && (summary.count != rows || summary.volume != volume))) {
+            failures.report(ticker + ": aggregate disagrees with a cursor walk");
+            return false;
+        }
+        walked += rows;
+    }
+    if (tree.size() != walked) {
+        failures.report("size() is " + std::to_string(tree.size()) + ", walk found " + std::to_string(walked));
+        return false;
+    }
+    return true;
+}
+
+// Checks, from inside each notification, that the change is already
+// visible in the latest snapshot.
+class PublishedCheck : public TreeListener {
+public:
+    PublishedCheck(ConcurrentStore& store, Failures& failures) : calls(0), store(store), failures(failures) {}
+
+    void onMutation(const std::string& ticker, int day, MutationKind kind) override {
+        calls++;
+        StockData row;
+        bool present = store.snapshot()->search(ticker, DateUtils::toDateString(day), row);
+        if (present != (kind != MutationKind::Remove))
+            failures.report("listener ran before " + ticker + " " + DateUtils::toDateString(day) + " was published");
+    }
+
+    size_t calls;
+
+private:
+    ConcurrentStore& store;
+    Failures& failures;
+};
+
+bool concurrentStoreTest(std::ostream& out) {
+    ConcurrentStore store;
+    Failures failures;
+    PublishedCheck listener(store, failures);
+    store.addListener(&listener);
+    MetricsCache cache(store);
+
+    std::atomic<bool> writing{ true };
+    std::atomic<long> reads{ 0 };
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; r++) {
+        readers.emplace_back([&] {
+            while (writing.load() && failures.count.load() == 0) {
+                std::shared_ptr<const AVLTree> held = store.snapshot();
+                uint64_t before = checksum(*held);
+                checkVersion(*held, failures);
+                // Let the writer publish a few more versions, then make
+                // sure none of them reached into the one held here.
+                std::this_thread::yield();
+                checkVersion(*store.snapshot(), failures);
+                if (checksum(*held) != before) failures.report("a held snapshot changed after newer versions were published");
+                reads++;
+            }
+        });
+    }
+    // Fills the cache while versions are replaced under it.
+    readers.emplace_back([&] {
+        for (int i = 0; writing.load(); i++) {
+            cache.sma(tickerName(i % TICKERS), 5);
+            cache.volatility(tickerName(i % TICKERS));
+        }
+    });
+
+    // Step s adds day s, rewrites the volume of day s / 2 and, every third
+    // step, drops the oldest remaining day, for all tickers in one batch.
+    int oldest = 0;
+    for (int s = 0; s < STEPS && failures.count.load() == 0; s++) {
+        WriteBatch batch;
+        for (int t = 0; t < TICKERS; t++) {
+            std::string ticker = tickerName(t);
+            double price = 100 + s % 7;
+            batch.inserts.emplace_back(ticker, DateUtils::toDateString(FIRST_DAY + s), price, price, price + 1, price - 1, 1000 + s);
+            if (s / 2 >= oldest && s / 2 < s)
+                batch.updates.emplace_back(ticker, DateUtils::toDateString(FIRST_DAY + s / 2), price, price, price + 1, price - 1, 5000 + s);
+            if (s % 3 == 2)
+                batch.removals.emplace_back(ticker, DateUtils::toDateString(FIRST_DAY + oldest));
+        }
+        if (s % 3 == 2) oldest++;
+        store.apply(batch);
+    }
+    writing = false;
+    for (std::thread& reader : readers) reader.join();
+    store.removeListener(&listener);
+
+    checkVersion(*store.snapshot(), failures);
+    if (listener.calls == 0) failures.report("listener was never called");
+    // Nothing computed from a replaced version may have been kept.
+    MetricsCache fresh(store);
+    for (int t = 0; t < TICKERS; t++) {
+        std::string ticker = tickerName(t);
+        if (cache.sma(ticker, 5) != fresh.sma(ticker, 5) || cache.volatility(ticker) != fresh.volatility(ticker))
+            failures.report("metrics cache kept a value from a replaced version of " + ticker);
+    }
+
+    bool passed = failures.count.load() == 0;
+    out << "concurrent store: " << (passed ? "ok" : "FAILED") << " (" << STEPS << " batches, "
+        << READERS << " readers, " << reads.load() << " snapshot reads)";
+    if (!passed) out << ": " << failures.first;
+    out << "\n";
+    return passed;
+}
+
+}
+
+int runSelfTests(std::ostream& out) {
+    int failed = 0;
+    if (!concurrentStoreTest(out)) failed++;
+    return failed;
+}
@@ -0,0 +1,15 @@
+#ifndef SELFTEST_H
+#define SELFTEST_H
+
+#include <ostream>
+
+// "--selftest": checks that need threads and so do not fit a batch
+// script. Today that is ConcurrentStore under concurrent readers and a
+// writer: every snapshot must hold whole batches only, agree with itself
+// (size, cursor walk and subtree aggregates) and never change after it
+// was taken, store listeners must see each change already published and
+// a MetricsCache over the store must not keep values from old versions.
+// Writes one line per check to `out`; returns the number that failed.
+int runSelfTests(std::ostream& out);
+
+#endif
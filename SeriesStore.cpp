@@ -0,0 +1,147 @@
+#include "SeriesStore.h"
+#include "DateUtils.h"
+#include <algorithm>
+
+size_t TickerSeries::lowerBound(int day) const {
+    return std::lower_bound(dates.begin(), dates.end(), day) - dates.begin();
+}
+
+size_t TickerSeries::upperBound(int day) const {
+    return std::upper_bound(dates.begin(), dates.end(), day) - dates.begin();
+}
+
+StockData TickerSeries::row(const std::string& ticker, size_t i) const {
+    return StockData(ticker, DateUtils::toDateString(dates[i]),
+                     open[i], close[i], high[i], low[i], volume[i]);
+}
+
+void TickerSeries::insertAt(size_t i, int day, const StockData& data) {
+    dates.insert(dates.begin() + i, day);
+    open.insert(open.begin() + i, data.openPrice);
+    close.insert(close.begin() + i, data.closePrice);
+    high.insert(high.begin() + i, data.highPrice);
+    low.insert(low.begin() + i, data.lowPrice);
+    volume.insert(volume.begin() + i, data.volume);
+}
+
+void TickerSeries::setAt(size_t i, const StockData& data) {
+    open[i] = data.openPrice;
+    close[i] = data.closePrice;
+    high[i] = data.highPrice;
+    low[i] = data.lowPrice;
+    volume[i] = data.volume;
+}
+
+void TickerSeries::eraseAt(size_t i) {
+    dates.erase(dates.begin() + i);
+    open.erase(open.begin() + i);
+    close.erase(close.begin() + i);
+    high.erase(high.begin() + i);
+    low.erase(low.begin() + i);
+    volume.erase(volume.begin() + i);
+}
+
+SeriesStore::SeriesStore() : rowCount(0) {}
+
+// Like AVLTree::insert, an existing (ticker, date) is left untouched.
+bool SeriesStore::insert(const StockData& data) {
+    int day;
+    if (!DateUtils::parseDate(data.date, day)) return false;
+    TickerSeries& s = series[data.ticker];
+    size_t i = s.lowerBound(day);
+    if (i < s.size() && s.dates[i] == day) return false;
+    s.insertAt(i, day, data);
+    rowCount++;
+    return true;
+}
+
+bool SeriesStore::search(const std::string& ticker, const std::string& date, StockData& out) const {
+    int day;
+    const TickerSeries* s = getSeries(ticker);
+    if (!s || !DateUtils::parseDate(date, day)) return false;
+    size_t i = s->lowerBound(day);
+    if (i == s->size() || s->dates[i] != day) return false;
+    out = s->row(ticker, i);
+    return true;
+}
+
+bool SeriesStore::update(const StockData& newData) {
+    int day;
+    auto it = series.find(newData.ticker);
+    if (it == series.end() || !DateUtils::parseDate(newData.date, day)) return false;
+    TickerSeries& s = it->second;
+    size_t i = s.lowerBound(day);
+    if (i == s.size() || s.dates[i] != day) return false;
+    s.setAt(i, newData);
+    return true;
+}
+
+bool SeriesStore::remove(const std::string& ticker, const std::string& date) {
+    int day;
+    auto it = series.find(ticker);
+    if (it == series.end() || !DateUtils::parseDate(date, day)) return false;
+    TickerSeries& s = it->second;
+    size_t i = s.lowerBound(day);
+    if (i == s.size() || s.dates[i] != day) return false;
+    s.eraseAt(i);
+    if (s.size() == 0) series.erase(it);
+    rowCount--;
+    return true;
+}
+
+std::vector<StockData> SeriesStore::getStocksByTicker(const std::string& ticker) const {
+    std::vector<StockData> result;
+    const TickerSeries* s = getSeries(ticker);
+    if (!s) return result;
+    result.reserve(s->size());
+    for (size_t i = 0; i < s->size(); i++)
+        result.push_back(s->row(ticker, i));
+    return result;
+}
+
+std::vector<StockData> SeriesStore::getStocksByDateRange(const std::string& ticker,
+                                                         const std::string& startDate,
+                                                         const std::string& endDate) const {
+    std::vector<StockData> result;
+    int startDay, endDay;
+    const TickerSeries* s = getSeries(ticker);
+    if (!s || !DateUtils::parseDate(startDate, startDay) || !DateUtils::parseDate(endDate, endDay))
+        return result;
+    size_t first = s->lowerBound(startDay);
+    size_t last = std::max(first, s->upperBound(endDay));
+    result.reserve(last - first);
+    for (size_t i = first; i < last; i++)
+        result.push_back(s->row(ticker, i));
+    return result;
+}
+
+// One contiguous copy out of the close column.
+std::vector<double> SeriesStore::closes(const std::string& ticker, int startDay, int endDay) const {
+    const TickerSeries* s = getSeries(ticker);
+    if (!s) return std::vector<double>();
+    size_t first = s->lowerBound(startDay);
+    size_t last = std::max(first, s->upperBound(endDay));
+    return std::vector<double>(s->close.begin() + first, s->close.begin() + last);
+}
+
+const TickerSeries* SeriesStore::getSeries(const std::string& ticker) const {
+    auto it = series.find(ticker);
+    return it == series.end() ? nullptr : &it->second;
+}
+
+std::vector<std::string> SeriesStore::getTickers() const {
+    std::vector<std::string> tickers;
+    tickers.reserve(series.size());
+    for (const auto& entry : series) tickers.push_back(entry.first);
+    return tickers;
+}
+
+size_t SeriesStore::bytesUsed() const {
+    size_t bytes = 0;
+    for (const auto& entry : series) {
+        const TickerSeries& s = entry.second;
+        bytes += s.dates.capacity() * sizeof(int) + s.volume.capacity() * sizeof(long) +
+                 (s.open.capacity() + s.close.capacity() + s.high.capacity() + s.low.capacity()) * sizeof(double);
+    }
+    return bytes;
+}
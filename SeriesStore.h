@@ -0,0 +1,61 @@
+#ifndef SERIESSTORE_H
+#define SERIESSTORE_H
+
+#include "HistoryStore.h"
+#include <map>
+#include <vector>
+#include <string>
+
+// One ticker's history stored column-wise and kept sorted by date, so
+// metric scans walk contiguous arrays instead of tree nodes. Also the
+// decoded form of a compressed block (see CompressedStore.h).
+struct TickerSeries {
+    std::vector<int> dates;         // days since 1970-01-01 (see DateUtils.h)
+    std::vector<double> open;
+    std::vector<double> close;
+    std::vector<double> high;
+    std::vector<double> low;
+    std::vector<long> volume;
+
+    size_t size() const { return dates.size(); }
+    size_t lowerBound(int day) const;   // first index with dates[i] >= day
+    size_t upperBound(int day) const;   // first index with dates[i] > day
+    StockData row(const std::string& ticker, size_t i) const;
+
+    void insertAt(size_t i, int day, const StockData& data);
+    void setAt(size_t i, const StockData& data);
+    void eraseAt(size_t i);
+};
+
+// Column store with the same CRUD/retrieval surface as AVLTree.
+// Appends in date order are O(1); out-of-order inserts shift the tail
+// of that ticker's columns only.
+class SeriesStore : public HistoryStore {
+private:
+    std::map<std::string, TickerSeries> series;
+    size_t rowCount;
+
+public:
+    SeriesStore();
+
+    // CRUD Operations
+    bool insert(const StockData& data) override;
+    bool search(const std::string& ticker, const std::string& date, StockData& out) const override;
+    bool update(const StockData& newData) override;
+    bool remove(const std::string& ticker, const std::string& date) override;
+
+    // Data Retrieval
+    std::vector<StockData> getStocksByTicker(const std::string& ticker) const override;
+    std::vector<StockData> getStocksByDateRange(const std::string& ticker,
+                                                const std::string& startDate,
+                                                const std::string& endDate) const override;
+    std::vector<double> closes(const std::string& ticker, int startDay, int endDay) const override;
+
+    // Column access, valid until the next write
+    const TickerSeries* getSeries(const std::string& ticker) const;
+    std::vector<std::string> getTickers() const override;
+    size_t size() const override { return rowCount; }
+    size_t bytesUsed() const override;
+};
+
+#endif
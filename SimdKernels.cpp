@@ -0,0 +1,398 @@
+#include "SimdKernels.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define MM_SIMD_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MM_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define MM_TARGET_AVX2
+#endif
+
+namespace {
+    struct KernelTable {
+        double (*sum)(const double*, size_t);
+        double (*sumSquaredDeviations)(const double*, size_t, double);
+        void (*minMax)(const double*, size_t, double&, double&);
+        void (*ratios)(const double*, size_t, double*);     // x[i + 1] / x[i]
+        void (*axpy)(double*, double, const double*, size_t);
+        void (*rank4Update)(double*, size_t, const double*, const double*, size_t);
+    };
+
+    // ---- Scalar ----
+
+    double scalarSum(const double* x, size_t n) {
+        double s = 0;
+        for (size_t i = 0; i < n; i++) s += x[i];
+        return s;
+    }
+
+    double scalarSumSquaredDeviations(const double* x, size_t n, double mean) {
+        double s = 0;
+        for (size_t i = 0; i < n; i++) s += (x[i] - mean) * (x[i] - mean);
+        return s;
+    }
+
+    void scalarMinMax(const double* x, size_t n, double& lo, double& hi) {
+        lo = hi = x[0];
+        for (size_t i = 1; i < n; i++) {
+            lo = std::min(lo, x[i]);
+            hi = std::max(hi, x[i]);
+        }
+    }
+
+    void scalarRatios(const double* x, size_t n, double* out) {
+        for (size_t i = 0; i + 1 < n; i++) out[i] = x[i + 1] / x[i];
+    }
+
+    void scalarAxpy(double* y, double a, const double* x, size_t n) {
+        for (size_t i = 0; i < n; i++) y[i] += a * x[i];
+    }
+
+    void scalarRank4Update(double* c, size_t stride, const double* a, const double* b, size_t n) {
+        double* c0 = c;
+        double* c1 = c + stride;
+        double* c2 = c + 2 * stride;
+        double* c3 = c + 3 * stride;
+        for (size_t j = 0; j < n; j++) {
+            c0[j] += a[0] * b[j];
+            c1[j] += a[1] * b[j];
+            c2[j] += a[2] * b[j];
+            c3[j] += a[3] * b[j];
+        }
+    }
+
+    const KernelTable scalarTable = { scalarSum, scalarSumSquaredDeviations, scalarMinMax, scalarRatios,
+                                      scalarAxpy, scalarRank4Update };
+
+#ifdef MM_SIMD_X86
+    // ---- SSE2 (x86-64 baseline) ----
+
+    double sse2Sum(const double* x, size_t n) {
+        __m128d a0 = _mm_setzero_pd(), a1 = _mm_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            a0 = _mm_add_pd(a0, _mm_loadu_pd(x + i));
+            a1 = _mm_add_pd(a1, _mm_loadu_pd(x + i + 2));
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, _mm_add_pd(a0, a1));
+        double s = lanes[0] + lanes[1];
+        for (; i < n; i++) s += x[i];
+        return s;
+    }
+
+    double sse2SumSquaredDeviations(const double* x, size_t n, double mean) {
+        const __m128d m = _mm_set1_pd(mean);
+        __m128d a0 = _mm_setzero_pd(), a1 = _mm_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128d d0 = _mm_sub_pd(_mm_loadu_pd(x + i), m);
+            __m128d d1 = _mm_sub_pd(_mm_loadu_pd(x + i + 2), m);
+            a0 = _mm_add_pd(a0, _mm_mul_pd(d0, d0));
+            a1 = _mm_add_pd(a1, _mm_mul_pd(d1, d1));
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, _mm_add_pd(a0, a1));
+        double s = lanes[0] + lanes[1];
+        for (; i < n; i++) s += (x[i] - mean) * (x[i] - mean);
+        return s;
+    }
+
+    void sse2MinMax(const double* x, size_t n, double& lo, double& hi) {
+        if (n < 2) {
+            scalarMinMax(x, n, lo, hi);
+            return;
+        }
+        __m128d vlo = _mm_loadu_pd(x), vhi = vlo;
+        size_t i = 2;
+        for (; i + 2 <= n; i += 2) {
+            __m128d v = _mm_loadu_pd(x + i);
+            vlo = _mm_min_pd(vlo, v);
+            vhi = _mm_max_pd(vhi, v);
+        }
+        double l[2], h[2];
+        _mm_storeu_pd(l, vlo);
+        _mm_storeu_pd(h, vhi);
+        lo = std::min(l[0], l[1]);
+        hi = std::max(h[0], h[1]);
+        for (; i < n; i++) {
+            lo = std::min(lo, x[i]);
+            hi = std::max(hi, x[i]);
+        }
+    }
+
+    void sse2Ratios(const double* x, size_t n, double* out) {
+        size_t i = 0;
+        for (; i + 3 <= n; i += 2)
+            _mm_storeu_pd(out + i, _mm_div_pd(_mm_loadu_pd(x + i + 1), _mm_loadu_pd(x + i)));
+        for (; i + 1 < n; i++) out[i] = x[i + 1] / x[i];
+    }
+
+    void sse2Axpy(double* y, double a, const double* x, size_t n) {
+        const __m128d va = _mm_set1_pd(a);
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2)
+            _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_mul_pd(va, _mm_loadu_pd(x + i))));
+        for (; i < n; i++) y[i] += a * x[i];
+    }
+
+    void sse2Rank4Update(double* c, size_t stride, const double* a, const double* b, size_t n) {
+        double* c0 = c;
+        double* c1 = c + stride;
+        double* c2 = c + 2 * stride;
+        double* c3 = c + 3 * stride;
+        const __m128d a0 = _mm_set1_pd(a[0]), a1 = _mm_set1_pd(a[1]);
+        const __m128d a2 = _mm_set1_pd(a[2]), a3 = _mm_set1_pd(a[3]);
+        size_t j = 0;
+        for (; j + 2 <= n; j += 2) {
+            __m128d v = _mm_loadu_pd(b + j);
+            _mm_storeu_pd(c0 + j, _mm_add_pd(_mm_loadu_pd(c0 + j), _mm_mul_pd(a0, v)));
+            _mm_storeu_pd(c1 + j, _mm_add_pd(_mm_loadu_pd(c1 + j), _mm_mul_pd(a1, v)));
+            _mm_storeu_pd(c2 + j, _mm_add_pd(_mm_loadu_pd(c2 + j), _mm_mul_pd(a2, v)));
+            _mm_storeu_pd(c3 + j, _mm_add_pd(_mm_loadu_pd(c3 + j), _mm_mul_pd(a3, v)));
+        }
+        for (; j < n; j++) {
+            c0[j] += a[0] * b[j];
+            c1[j] += a[1] * b[j];
+            c2[j] += a[2] * b[j];
+            c3[j] += a[3] * b[j];
+        }
+    }
+
+    const KernelTable sse2Table = { sse2Sum, sse2SumSquaredDeviations, sse2MinMax, sse2Ratios,
+                                    sse2Axpy, sse2Rank4Update };
+
+    // ---- AVX2 ----
+
+    MM_TARGET_AVX2 double avx2HorizontalSum(__m256d v) {
+        __m128d lo = _mm256_castpd256_pd128(v);
+        __m128d hi = _mm256_extractf128_pd(v, 1);
+        __m128d s = _mm_add_pd(lo, hi);
+        return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+    }
+
+    MM_TARGET_AVX2 double avx2Sum(const double* x, size_t n) {
+        __m256d a0 = _mm256_setzero_pd(), a1 = _mm256_setzero_pd();
+        __m256d a2 = _mm256_setzero_pd(), a3 = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            a0 = _mm256_add_pd(a0, _mm256_loadu_pd(x + i));
+            a1 = _mm256_add_pd(a1, _mm256_loadu_pd(x + i + 4));
+            a2 = _mm256_add_pd(a2, _mm256_loadu_pd(x + i + 8));
+            a3 = _mm256_add_pd(a3, _mm256_loadu_pd(x + i + 12));
+        }
+        for (; i + 4 <= n; i += 4)
+            a0 = _mm256_add_pd(a0, _mm256_loadu_pd(x + i));
+        double s = avx2HorizontalSum(_mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3)));
+        for (; i < n; i++) s += x[i];
+        return s;
+    }
+
+    MM_TARGET_AVX2 double avx2SumSquaredDeviations(const double* x, size_t n, double mean) {
+        const __m256d m = _mm256_set1_pd(mean);
+        __m256d a0 = _mm256_setzero_pd(), a1 = _mm256_setzero_pd();
+        __m256d a2 = _mm256_setzero_pd(), a3 = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(x + i), m);
+            __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(x + i + 4), m);
+            __m256d d2 = _mm256_sub_pd(_mm256_loadu_pd(x + i + 8), m);
+            __m256d d3 = _mm256_sub_pd(_mm256_loadu_pd(x + i + 12), m);
+            a0 = _mm256_add_pd(a0, _mm256_mul_pd(d0, d0));
+            a1 = _mm256_add_pd(a1, _mm256_mul_pd(d1, d1));
+            a2 = _mm256_add_pd(a2, _mm256_mul_pd(d2, d2));
+            a3 = _mm256_add_pd(a3, _mm256_mul_pd(d3, d3));
+        }
+        for (; i + 4 <= n; i += 4) {
+            __m256d d = _mm256_sub_pd(_mm256_loadu_pd(x + i), m);
+            a0 = _mm256_add_pd(a0, _mm256_mul_pd(d, d));
+        }
+        double s = avx2HorizontalSum(_mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3)));
+        for (; i < n; i++) s += (x[i] - mean) * (x[i] - mean);
+        return s;
+    }
+
+    MM_TARGET_AVX2 void avx2MinMax(const double* x, size_t n, double& lo, double& hi) {
+        if (n < 4) {
+            scalarMinMax(x, n, lo, hi);
+            return;
+        }
+        __m256d vlo = _mm256_loadu_pd(x), vhi = vlo;
+        size_t i = 4;
+        for (; i + 4 <= n; i += 4) {
+            __m256d v = _mm256_loadu_pd(x + i);
+            vlo = _mm256_min_pd(vlo, v);
+            vhi = _mm256_max_pd(vhi, v);
+        }
+        double l[4], h[4];
+        _mm256_storeu_pd(l, vlo);
+        _mm256_storeu_pd(h, vhi);
+        lo = std::min(std::min(l[0], l[1]), std::min(l[2], l[3]));
+        hi = std::max(std::max(h[0], h[1]), std::max(h[2], h[3]));
+        for (; i < n; i++) {
+            lo = std::min(lo, x[i]);
+            hi = std::max(hi, x[i]);
+        }
+    }
+
+    MM_TARGET_AVX2 void avx2Ratios(const double* x, size_t n, double* out) {
+        size_t i = 0;
+        for (; i + 5 <= n; i += 4)
+            _mm256_storeu_pd(out + i, _mm256_div_pd(_mm256_loadu_pd(x + i + 1), _mm256_loadu_pd(x + i)));
+        for (; i + 1 < n; i++) out[i] = x[i + 1] / x[i];
+    }
+
+    MM_TARGET_AVX2 void avx2Axpy(double* y, double a, const double* x, size_t n) {
+        const __m256d va = _mm256_set1_pd(a);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+            _mm256_storeu_pd(y + i, _mm256_add_pd(_mm256_loadu_pd(y + i), _mm256_mul_pd(va, _mm256_loadu_pd(x + i))));
+        for (; i < n; i++) y[i] += a * x[i];
+    }
+
+    MM_TARGET_AVX2 void avx2Rank4Update(double* c, size_t stride, const double* a, const double* b, size_t n) {
+        double* c0 = c;
+        double* c1 = c + stride;
+        double* c2 = c + 2 * stride;
+        double* c3 = c + 3 * stride;
+        const __m256d a0 = _mm256_set1_pd(a[0]), a1 = _mm256_set1_pd(a[1]);
+        const __m256d a2 = _mm256_set1_pd(a[2]), a3 = _mm256_set1_pd(a[3]);
+        size_t j = 0;
+        for (; j + 4 <= n; j += 4) {
+            __m256d v = _mm256_loadu_pd(b + j);
+            _mm256_storeu_pd(c0 + j, _mm256_add_pd(_mm256_loadu_pd(c0 + j), _mm256_mul_pd(a0, v)));
+            _mm256_storeu_pd(c1 + j, _mm256_add_pd(_mm256_loadu_pd(c1 + j), _mm256_mul_pd(a1, v)));
+            _mm256_storeu_pd(c2 + j, _mm256_add_pd(_mm256_loadu_pd(c2 + j), _mm256_mul_pd(a2, v)));
+            _mm256_storeu_pd(c3 + j, _mm256_add_pd(_mm256_loadu_pd(c3 + j), _mm256_mul_pd(a3, v)));
+        }
+        for (; j < n; j++) {
+            c0[j] += a[0] * b[j];
+            c1[j] += a[1] * b[j];
+            c2[j] += a[2] * b[j];
+            c3[j] += a[3] * b[j];
+        }
+    }
+
+    const KernelTable avx2Table = { avx2Sum, avx2SumSquaredDeviations, avx2MinMax, avx2Ratios,
+                                    avx2Axpy, avx2Rank4Update };
+
+    bool cpuHasAvx2() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+    SimdKernels::KernelLevel detectLevel() {
+#ifdef MM_SIMD_X86
+        return cpuHasAvx2() ? SimdKernels::KernelLevel::AVX2 : SimdKernels::KernelLevel::SSE2;
+#else
+        return SimdKernels::KernelLevel::Scalar;
+#endif
+    }
+
+    const KernelTable* tableFor(SimdKernels::KernelLevel level) {
+#ifdef MM_SIMD_X86
+        if (level == SimdKernels::KernelLevel::AVX2) return &avx2Table;
+        if (level == SimdKernels::KernelLevel::SSE2) return &sse2Table;
+#endif
+        (void)level;
+        return &scalarTable;
+    }
+
+    std::atomic<int>& levelSlot() {
+        static std::atomic<int> slot(static_cast<int>(detectLevel()));
+        return slot;
+    }
+
+    const KernelTable& kernels() {
+        return *tableFor(static_cast<SimdKernels::KernelLevel>(levelSlot().load(std::memory_order_relaxed)));
+    }
+}
+
+SimdKernels::KernelLevel SimdKernels::bestLevel() {
+    static const KernelLevel best = detectLevel();
+    return best;
+}
+
+SimdKernels::KernelLevel SimdKernels::activeLevel() {
+    return static_cast<KernelLevel>(levelSlot().load(std::memory_order_relaxed));
+}
+
+void SimdKernels::setLevel(KernelLevel level) {
+    if (static_cast<int>(level) > static_cast<int>(bestLevel())) level = bestLevel();
+    levelSlot().store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+const char* SimdKernels::levelName(KernelLevel level) {
+    switch (level) {
+        case KernelLevel::AVX2: return "avx2";
+        case KernelLevel::SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+double SimdKernels::sum(const double* x, size_t n) {
+    return kernels().sum(x, n);
+}
+
+double SimdKernels::mean(const double* x, size_t n) {
+    return n ? sum(x, n) / n : 0;
+}
+
+// Two passes (mean, then squared deviations) keep the vector lanes
+// independent and avoid the cancellation of the sum-of-squares formula.
+double SimdKernels::variance(const double* x, size_t n) {
+    if (n == 0) return 0;
+    const KernelTable& k = kernels();
+    double m = k.sum(x, n) / n;
+    return k.sumSquaredDeviations(x, n, m) / n;
+}
+
+void SimdKernels::minMax(const double* x, size_t n, double& minValue, double& maxValue) {
+    if (n == 0) {
+        minValue = maxValue = 0;
+        return;
+    }
+    kernels().minMax(x, n, minValue, maxValue);
+}
+
+void SimdKernels::returns(const double* x, size_t n, double* out) {
+    if (n < 2) return;
+    kernels().ratios(x, n, out);
+    for (size_t i = 0; i + 1 < n; i++) out[i] -= 1;
+}
+
+void SimdKernels::logReturns(const double* x, size_t n, double* out) {
+    if (n < 2) return;
+    kernels().ratios(x, n, out);
+    for (size_t i = 0; i + 1 < n; i++) out[i] = std::log(out[i]);
+}
+
+void SimdKernels::axpy(double* y, double a, const double* x, size_t n) {
+    kernels().axpy(y, a, x, n);
+}
+
+void SimdKernels::rank4Update(double* c, size_t stride, const double* a, const double* b, size_t n) {
+    kernels().rank4Update(c, stride, a, b, n);
+}
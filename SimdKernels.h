@@ -0,0 +1,41 @@
+#ifndef SIMDKERNELS_H
+#define SIMDKERNELS_H
+
+#include <cstddef>
+
+// Arithmetic kernels over contiguous double arrays. The implementation is
+// picked once at runtime: AVX2 when the CPU and OS support it, SSE2 on
+// any other x86-64 CPU, and portable scalar code elsewhere.
+//
+// Tolerance: sum/mean/variance accumulate in several lanes, so they are
+// reassociated relative to the scalar loop. Results agree with the scalar
+// kernel to within n * 2^-52 * sum(|x|) (sum) and the corresponding
+// relative error for mean and variance. minMax, returns, logReturns, axpy
+// and rank4Update are lane-independent and match the scalar results
+// exactly.
+// Inputs are assumed NaN-free.
+namespace SimdKernels {
+    enum class KernelLevel { Scalar, SSE2, AVX2 };
+
+    KernelLevel bestLevel();            // what this CPU supports
+    KernelLevel activeLevel();
+    void setLevel(KernelLevel level);   // clamped to bestLevel(); for testing
+    const char* levelName(KernelLevel level);
+
+    double sum(const double* x, size_t n);
+    double mean(const double* x, size_t n);
+    double variance(const double* x, size_t n);     // population
+    void minMax(const double* x, size_t n, double& minValue, double& maxValue);
+
+    // out[i] = x[i + 1] / x[i] - 1 and log(x[i + 1] / x[i]); out holds n - 1 values.
+    void returns(const double* x, size_t n, double* out);
+    void logReturns(const double* x, size_t n, double* out);
+
+    // y[j] += a * x[j]
+    void axpy(double* y, double a, const double* x, size_t n);
+    // c[r * stride + j] += a[r] * b[j] for r in [0, 4): four axpy rows
+    // sharing each load of b, the inner step of a blocked matrix product.
+    void rank4Update(double* c, size_t stride, const double* a, const double* b, size_t n);
+}
+
+#endif
@@ -0,0 +1,85 @@
+#include "SlabAllocator.h"
+#include <algorithm>
+#include <new>
+
+SlabAllocator::SlabAllocator(size_t blockSize, size_t blockAlign, size_t blocksPerSlab)
+    : blockSize(0), blocksPerSlab(blocksPerSlab),
+      bump(nullptr), bumpEnd(nullptr), freeList(nullptr), freeCount(0), live(0), peak(0),
+      returned(nullptr), returnedCount(0) {
+    // Slabs come from operator new, so rounding the block size keeps
+    // every block aligned.
+    size_t align = std::max(blockAlign, alignof(FreeBlock));
+    this->blockSize = (std::max(blockSize, sizeof(FreeBlock)) + align - 1) / align * align;
+}
+
+SlabAllocator::~SlabAllocator() {
+    for (char* slab : slabs) ::operator delete(slab);
+}
+
+void SlabAllocator::addSlab() {
+    char* slab = static_cast<char*>(::operator new(blockSize * blocksPerSlab));
+    slabs.push_back(slab);
+    bump = slab;
+    bumpEnd = slab + blockSize * blocksPerSlab;
+}
+
+void* SlabAllocator::allocate() {
+    if (!freeList && returnedCount.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(returnMutex);
+        freeList = returned;
+        freeCount = returnedCount;
+        live -= freeCount;
+        returned = nullptr;
+        returnedCount = 0;
+    }
+    void* block;
+    if (freeList) {
+        block = freeList;
+        freeList = freeList->next;
+        freeCount--;
+    } else {
+        if (bump == bumpEnd) addSlab();
+        block = bump;
+        bump += blockSize;
+    }
+    if (++live > peak) peak = live;
+    return block;
+}
+
+void SlabAllocator::release(void* block) {
+    FreeBlock* freed = static_cast<FreeBlock*>(block);
+    freed->next = freeList;
+    freeList = freed;
+    freeCount++;
+    live--;
+}
+
+void SlabAllocator::releaseShared(void* const* blocks, size_t n) {
+    if (n == 0) return;
+    // Link the batch outside the lock, then splice it in.
+    FreeBlock* head = nullptr;
+    FreeBlock* tail = nullptr;
+    for (size_t i = 0; i < n; i++) {
+        FreeBlock* freed = static_cast<FreeBlock*>(blocks[i]);
+        freed->next = head;
+        head = freed;
+        if (!tail) tail = freed;
+    }
+    std::lock_guard<std::mutex> lock(returnMutex);
+    tail->next = returned;
+    returned = head;
+    returnedCount += n;
+}
+
+SlabStats SlabAllocator::stats() const {
+    SlabStats s;
+    s.blockSize = blockSize;
+    s.slabs = slabs.size();
+    s.bytesReserved = slabs.size() * blockSize * blocksPerSlab;
+    s.peakBlocks = peak;
+    std::lock_guard<std::mutex> lock(returnMutex);
+    size_t pending = returnedCount;
+    s.liveBlocks = live - pending;
+    s.freeBlocks = freeCount + pending + static_cast<size_t>(bumpEnd - bump) / blockSize;
+    return s;
+}
@@ -0,0 +1,60 @@
+#ifndef SLABALLOCATOR_H
+#define SLABALLOCATOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+struct SlabStats {
+    size_t blockSize;
+    size_t slabs;
+    size_t bytesReserved;
+    size_t liveBlocks;
+    size_t peakBlocks;
+    size_t freeBlocks;      // carved out but currently unused
+};
+
+// Fixed-size block allocator for tree nodes. Blocks are bump-allocated
+// out of large slabs and recycled through an intrusive free list, so an
+// allocation is a few instructions and carries no per-block header.
+// Destroying the allocator frees whole slabs without visiting blocks;
+// objects placed in it must therefore be trivially destructible.
+//
+// allocate() and release() belong to the owning thread. releaseShared()
+// may be called from any thread; those blocks are picked up the next
+// time the owner's free list runs dry.
+class SlabAllocator {
+private:
+    struct FreeBlock { FreeBlock* next; };
+
+    size_t blockSize;
+    size_t blocksPerSlab;
+    std::vector<char*> slabs;
+    char* bump;
+    char* bumpEnd;
+    FreeBlock* freeList;
+    size_t freeCount;
+    size_t live;
+    size_t peak;
+
+    mutable std::mutex returnMutex;
+    FreeBlock* returned;
+    std::atomic<size_t> returnedCount;
+
+    void addSlab();
+
+public:
+    SlabAllocator(size_t blockSize, size_t blockAlign, size_t blocksPerSlab = 4096);
+    ~SlabAllocator();
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    void* allocate();
+    void release(void* block);
+    void releaseShared(void* const* blocks, size_t n);
+
+    SlabStats stats() const;
+};
+
+#endif
@@ -0,0 +1,358 @@
+#include "Snapshot.h"
+#include "DateUtils.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    const char MAGIC[8] = { 'M', 'M', 'S', 'N', 'A', 'P', '\0', '\0' };
+    const uint32_t ENDIAN_TAG = 0x01020304;
+    const size_t WRITE_BUFFER_BYTES = 1 << 20;
+
+    static_assert(sizeof(SnapshotHeader) % 8 == 0, "header must keep sections aligned");
+    static_assert(sizeof(SnapshotTicker) == 24, "ticker entry layout changed");
+
+    // Forces the file's contents to disk, so a rename that publishes it
+    // can never be durable before the data is.
+    bool syncFile(FILE* f) {
+        if (fflush(f) != 0) return false;
+#ifdef _WIN32
+        return _commit(_fileno(f)) == 0;
+#else
+        return fsync(fileno(f)) == 0;
+#endif
+    }
+
+    uint64_t align8(uint64_t n) {
+        return (n + 7) & ~static_cast<uint64_t>(7);
+    }
+
+    // Word-at-a-time hash; n must be a multiple of 8.
+    uint64_t checksumBytes(uint64_t h, const char* p, size_t n) {
+        for (size_t i = 0; i < n; i += 8) {
+            uint64_t w;
+            memcpy(&w, p + i, 8);
+            h ^= w * 0x9E3779B97F4A7C15ull;
+            h = (h << 31) | (h >> 33);
+            h *= 0xC2B2AE3D27D4EB4Full;
+        }
+        return h;
+    }
+
+    // Buffers output in 1 MiB blocks and checksums each block as it is
+    // flushed. Every section is padded to 8 bytes so blocks stay whole words.
+    class SectionWriter {
+    private:
+        FILE* out;
+        std::vector<char> buffer;
+        size_t used;
+        uint64_t written;
+        bool failed;
+
+    public:
+        uint64_t checksum;
+
+        explicit SectionWriter(FILE* f)
+            : out(f), buffer(WRITE_BUFFER_BYTES), used(0), written(0), failed(false), checksum(0) {}
+
+        void write(const void* data, size_t n) {
+            const char* p = static_cast<const char*>(data);
+            while (n > 0) {
+                size_t take = std::min(n, buffer.size() - used);
+                memcpy(buffer.data() + used, p, take);
+                used += take;
+                p += take;
+                n -= take;
+                if (used == buffer.size()) flush();
+            }
+        }
+
+        void pad() {
+            static const char zeros[8] = {};
+            size_t total = static_cast<size_t>(written + used);
+            write(zeros, static_cast<size_t>(align8(total) - total));
+        }
+
+        bool flush() {
+            if (used == 0) return !failed;
+            checksum = checksumBytes(checksum, buffer.data(), used);
+            if (fwrite(buffer.data(), 1, used, out) != used) failed = true;
+            written += used;
+            used = 0;
+            return !failed;
+        }
+    };
+
+    template <typename Fn>
+    void writeColumn(SectionWriter& writer, const AVLTree& tree,
+                     const std::vector<std::string>& tickers, Fn field) {
+        for (const auto& t : tickers)
+            for (RangeCursor c = tree.scanTicker(t); c.valid(); c.next()) {
+                auto value = field(c);
+                writer.write(&value, sizeof(value));
+            }
+        writer.pad();
+    }
+}
+
+Snapshot::Snapshot()
+    : header(nullptr), tickers(nullptr), names(nullptr), dateColumn(nullptr), openColumn(nullptr),
+      closeColumn(nullptr), highColumn(nullptr), lowColumn(nullptr), volumeColumn(nullptr) {}
+
+bool Snapshot::write(const AVLTree& tree, const std::string& path, std::string& error) {
+    std::vector<std::string> tickerNames = tree.getTickers();
+
+    std::vector<SnapshotTicker> table;
+    std::string blob;
+    uint64_t rows = 0;
+    for (const auto& name : tickerNames) {
+        SnapshotTicker entry = { rows, 0, static_cast<uint32_t>(blob.size()),
+                                 static_cast<uint32_t>(name.size()) };
+        for (RangeCursor c = tree.scanTicker(name); c.valid(); c.next()) entry.rowCount++;
+        rows += entry.rowCount;
+        blob += name;
+        table.push_back(entry);
+    }
+
+    SnapshotHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = VERSION;
+    h.endianTag = ENDIAN_TAG;
+    h.tickerCount = table.size();
+    h.rowCount = rows;
+    h.tickersOffset = sizeof(SnapshotHeader);
+    h.namesOffset = h.tickersOffset + table.size() * sizeof(SnapshotTicker);
+    h.namesBytes = blob.size();
+    h.datesOffset = align8(h.namesOffset + blob.size());
+    h.openOffset = align8(h.datesOffset + rows * sizeof(int32_t));
+    h.closeOffset = h.openOffset + rows * sizeof(double);
+    h.highOffset = h.closeOffset + rows * sizeof(double);
+    h.lowOffset = h.highOffset + rows * sizeof(double);
+    h.volumeOffset = h.lowOffset + rows * sizeof(double);
+    h.fileSize = h.volumeOffset + rows * sizeof(int64_t);
+
+    // Write beside the target and rename, so a crash never leaves a torn snapshot.
+    std::string tmpPath = path + ".tmp";
+    FILE* out = fopen(tmpPath.c_str(), "wb");
+    if (!out) {
+        error = "cannot create " + tmpPath;
+        return false;
+    }
+    fwrite(&h, sizeof(h), 1, out);
+
+    SectionWriter writer(out);
+    if (!table.empty()) writer.write(table.data(), table.size() * sizeof(SnapshotTicker));
+    writer.write(blob.data(), blob.size());
+    writer.pad();
+    writeColumn(writer, tree, tickerNames, [](const RangeCursor& c) { return static_cast<int32_t>(keyDay(c.key())); });
+    writeColumn(writer, tree, tickerNames, [](const RangeCursor& c) { return c->openPrice; });
+    writeColumn(writer, tree, tickerNames, [](const RangeCursor& c) { return c->closePrice; });
+    writeColumn(writer, tree, tickerNames, [](const RangeCursor& c) { return c->highPrice; });
+    writeColumn(writer, tree, tickerNames, [](const RangeCursor& c) { return c->lowPrice; });
+    writeColumn(writer, tree, tickerNames, [](const RangeCursor& c) { return static_cast<int64_t>(c->volume); });
+    bool ok = writer.flush();
+
+    h.checksum = writer.checksum;
+    ok = ok && fseek(out, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, out) == 1;
+    ok = ok && syncFile(out);
+    ok = (fclose(out) == 0) && ok;
+    if (!ok) {
+        std::remove(tmpPath.c_str());
+        error = "write failed for " + tmpPath;
+        return false;
+    }
+#ifdef _WIN32
+    if (!MoveFileExA(tmpPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+#else
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+#endif
+        error = "cannot replace " + path;
+        return false;
+    }
+    return true;
+}
+
+bool Snapshot::open(const std::string& path, bool verify, std::string& error) {
+    header = nullptr;
+    if (!file.open(path)) {
+        error = "cannot open " + path;
+        return false;
+    }
+    const uint64_t size = file.size();
+    const SnapshotHeader* h = reinterpret_cast<const SnapshotHeader*>(file.data());
+    if (size < sizeof(SnapshotHeader) || memcmp(h->magic, MAGIC, sizeof(MAGIC)) != 0) {
+        error = "not a snapshot file";
+        return false;
+    }
+    if (h->endianTag != ENDIAN_TAG || h->version != VERSION) {
+        error = "unsupported snapshot version or byte order";
+        return false;
+    }
+
+    auto inBounds = [size](uint64_t offset, uint64_t count, uint64_t width) {
+        return offset % 8 == 0 && offset <= size && count <= (size - offset) / width;
+    };
+    if (h->fileSize != size ||
+        !inBounds(h->tickersOffset, h->tickerCount, sizeof(SnapshotTicker)) ||
+        !inBounds(h->namesOffset, h->namesBytes, 1) ||
+        !inBounds(h->datesOffset, h->rowCount, sizeof(int32_t)) ||
+        !inBounds(h->openOffset, h->rowCount, sizeof(double)) ||
+        !inBounds(h->closeOffset, h->rowCount, sizeof(double)) ||
+        !inBounds(h->highOffset, h->rowCount, sizeof(double)) ||
+        !inBounds(h->lowOffset, h->rowCount, sizeof(double)) ||
+        !inBounds(h->volumeOffset, h->rowCount, sizeof(int64_t))) {
+        error = "snapshot is truncated or corrupt";
+        return false;
+    }
+
+    const char* base = file.data();
+    const SnapshotTicker* table = reinterpret_cast<const SnapshotTicker*>(base + h->tickersOffset);
+    for (uint64_t i = 0; i < h->tickerCount; i++) {
+        const SnapshotTicker& t = table[i];
+        if (t.firstRow > h->rowCount || t.rowCount > h->rowCount - t.firstRow ||
+            t.nameOffset > h->namesBytes || t.nameLength > h->namesBytes - t.nameOffset) {
+            error = "snapshot ticker table is corrupt";
+            return false;
+        }
+    }
+
+    header = h;
+    tickers = table;
+    names = base + h->namesOffset;
+    dateColumn = reinterpret_cast<const int32_t*>(base + h->datesOffset);
+    openColumn = reinterpret_cast<const double*>(base + h->openOffset);
+    closeColumn = reinterpret_cast<const double*>(base + h->closeOffset);
+    highColumn = reinterpret_cast<const double*>(base + h->highOffset);
+    lowColumn = reinterpret_cast<const double*>(base + h->lowOffset);
+    volumeColumn = reinterpret_cast<const int64_t*>(base + h->volumeOffset);
+
+    if (verify && !verifyChecksum()) {
+        header = nullptr;
+        error = "snapshot checksum mismatch";
+        return false;
+    }
+    return true;
+}
+
+bool Snapshot::verifyChecksum() const {
+    if (!header) return false;
+    const char* body = file.data() + sizeof(SnapshotHeader);
+    return checksumBytes(0, body, static_cast<size_t>(header->fileSize - sizeof(SnapshotHeader))) == header->checksum;
+}
+
+std::string Snapshot::tickerName(size_t i) const {
+    return std::string(names + tickers[i].nameOffset, tickers[i].nameLength);
+}
+
+int Snapshot::findTicker(const std::string& ticker) const {
+    size_t lo = 0, hi = tickerCount();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const SnapshotTicker& t = tickers[mid];
+        int cmp = ticker.compare(0, ticker.size(), names + t.nameOffset, t.nameLength);
+        if (cmp == 0) return static_cast<int>(mid);
+        if (cmp < 0) hi = mid;
+        else lo = mid + 1;
+    }
+    return -1;
+}
+
+SnapshotRange Snapshot::rangeOf(const SnapshotTicker& t, size_t first, size_t last) const {
+    size_t row = static_cast<size_t>(t.firstRow) + first;
+    SnapshotRange range = { dateColumn + row, openColumn + row, closeColumn + row,
+                            highColumn + row, lowColumn + row, volumeColumn + row, last - first };
+    return range;
+}
+
+SnapshotRange Snapshot::getTicker(const std::string& ticker) const {
+    int i = findTicker(ticker);
+    if (i < 0) return SnapshotRange();
+    return rangeOf(tickers[i], 0, static_cast<size_t>(tickers[i].rowCount));
+}
+
+SnapshotRange Snapshot::getDays(const std::string& ticker, int startDay, int endDay) const {
+    int i = findTicker(ticker);
+    if (i < 0) return SnapshotRange();
+    const SnapshotTicker& t = tickers[i];
+    const int32_t* first = dateColumn + t.firstRow;
+    const int32_t* last = first + t.rowCount;
+    size_t lo = std::lower_bound(first, last, startDay) - first;
+    size_t hi = std::upper_bound(first, last, endDay) - first;
+    return rangeOf(t, lo, std::max(lo, hi));
+}
+
+SnapshotRange Snapshot::getDateRange(const std::string& ticker,
+                                     const std::string& startDate,
+                                     const std::string& endDate) const {
+    int startDay, endDay;
+    if (!DateUtils::parseDate(startDate, startDay) || !DateUtils::parseDate(endDate, endDay))
+        return SnapshotRange();
+    return getDays(ticker, startDay, endDay);
+}
+
+static std::vector<StockData> toRows(const std::string& ticker, const SnapshotRange& r) {
+    std::vector<StockData> result;
+    result.reserve(r.count);
+    for (size_t i = 0; i < r.count; i++)
+        result.push_back(StockData(ticker, DateUtils::toDateString(r.dates[i]), r.open[i], r.close[i],
+                                   r.high[i], r.low[i], static_cast<long>(r.volume[i])));
+    return result;
+}
+
+bool Snapshot::search(const std::string& ticker, const std::string& date, StockData& out) const {
+    SnapshotRange r = getDateRange(ticker, date, date);
+    if (r.count == 0) return false;
+    out = toRows(ticker, r)[0];
+    return true;
+}
+
+std::vector<StockData> Snapshot::getStocksByTicker(const std::string& ticker) const {
+    return toRows(ticker, getTicker(ticker));
+}
+
+std::vector<StockData> Snapshot::getStocksByDateRange(const std::string& ticker,
+                                                      const std::string& startDate,
+                                                      const std::string& endDate) const {
+    return toRows(ticker, getDateRange(ticker, startDate, endDate));
+}
+
+std::vector<double> Snapshot::closes(const std::string& ticker, int startDay, int endDay) const {
+    SnapshotRange r = getDays(ticker, startDay, endDay);
+    return std::vector<double>(r.close, r.close + r.count);
+}
+
+std::vector<std::string> Snapshot::getTickers() const {
+    std::vector<std::string> names;
+    names.reserve(tickerCount());
+    for (size_t i = 0; i < tickerCount(); i++) names.push_back(tickerName(i));
+    return names;
+}
+
+size_t Snapshot::loadInto(AVLTree& tree) const {
+    std::vector<std::string> tickerNames(tickerCount());
+    std::vector<TickerBar> rows;
+    rows.reserve(rowCount());
+    for (size_t t = 0; t < tickerCount(); t++) {
+        tickerNames[t] = tickerName(t);
+        size_t first = static_cast<size_t>(tickers[t].firstRow);
+        size_t last = first + static_cast<size_t>(tickers[t].rowCount);
+        for (size_t i = first; i < last; i++) {
+            TickerBar row = { static_cast<uint32_t>(t), dateColumn[i],
+                              { openColumn[i], closeColumn[i], highColumn[i], lowColumn[i],
+                                static_cast<long>(volumeColumn[i]) } };
+            rows.push_back(row);
+        }
+    }
+    return tree.bulkLoad(tickerNames, rows);
+}
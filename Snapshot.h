@@ -0,0 +1,114 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "AVLTree.h"
+#include "HistoryStore.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// On-disk layout (native byte order, every section 8-byte aligned):
+//   SnapshotHeader
+//   SnapshotTicker[tickerCount]     sorted by ticker name
+//   names blob                      ticker names, not terminated
+//   int32_t  dates[rowCount]        day numbers, grouped by ticker
+//   double   open/close/high/low[rowCount]
+//   int64_t  volume[rowCount]
+// The checksum covers every byte after the header.
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t endianTag;
+    uint64_t tickerCount;
+    uint64_t rowCount;
+    uint64_t tickersOffset;
+    uint64_t namesOffset;
+    uint64_t namesBytes;
+    uint64_t datesOffset;
+    uint64_t openOffset;
+    uint64_t closeOffset;
+    uint64_t highOffset;
+    uint64_t lowOffset;
+    uint64_t volumeOffset;
+    uint64_t fileSize;
+    uint64_t checksum;
+};
+
+struct SnapshotTicker {
+    uint64_t firstRow;
+    uint64_t rowCount;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+};
+
+// Rows of one ticker as pointers into the mapped columns.
+struct SnapshotRange {
+    const int32_t* dates;
+    const double* open;
+    const double* close;
+    const double* high;
+    const double* low;
+    const int64_t* volume;
+    size_t count;
+};
+
+// A read-only, memory-mapped snapshot. open() only validates the header
+// and section bounds, so queries can be served immediately; the full
+// checksum pass is optional. As a HistoryStore its writes return false;
+// "--batch --snapshot" reads from it until a command needs the tree.
+class Snapshot : public HistoryStore {
+private:
+    MappedFile file;
+    const SnapshotHeader* header;
+    const SnapshotTicker* tickers;
+    const char* names;
+    const int32_t* dateColumn;
+    const double* openColumn;
+    const double* closeColumn;
+    const double* highColumn;
+    const double* lowColumn;
+    const int64_t* volumeColumn;
+
+    int findTicker(const std::string& ticker) const;
+    SnapshotRange rangeOf(const SnapshotTicker& t, size_t first, size_t last) const;
+    SnapshotRange getDays(const std::string& ticker, int startDay, int endDay) const;
+
+public:
+    static const uint32_t VERSION = 1;
+
+    Snapshot();
+
+    static bool write(const AVLTree& tree, const std::string& path, std::string& error);
+
+    bool open(const std::string& path, bool verify, std::string& error);
+    bool verifyChecksum() const;
+
+    size_t tickerCount() const { return header ? static_cast<size_t>(header->tickerCount) : 0; }
+    size_t rowCount() const { return header ? static_cast<size_t>(header->rowCount) : 0; }
+    std::string tickerName(size_t i) const;
+
+    SnapshotRange getTicker(const std::string& ticker) const;
+    SnapshotRange getDateRange(const std::string& ticker,
+                               const std::string& startDate,
+                               const std::string& endDate) const;
+
+    // HistoryStore, served straight from the mapping
+    bool insert(const StockData&) override { return false; }
+    bool search(const std::string& ticker, const std::string& date, StockData& out) const override;
+    bool update(const StockData&) override { return false; }
+    bool remove(const std::string&, const std::string&) override { return false; }
+    std::vector<StockData> getStocksByTicker(const std::string& ticker) const override;
+    std::vector<StockData> getStocksByDateRange(const std::string& ticker,
+                                                const std::string& startDate,
+                                                const std::string& endDate) const override;
+    std::vector<double> closes(const std::string& ticker, int startDay, int endDay) const override;
+    std::vector<std::string> getTickers() const override;
+    size_t size() const override { return rowCount(); }
+    size_t bytesUsed() const override { return 0; }     // rows stay in the mapping
+
+    // Copies every row into the tree through AVLTree::bulkLoad.
+    size_t loadInto(AVLTree& tree) const;
+};
+
+#endif
@@ -0,0 +1,32 @@
+#include "SymbolTable.h"
+#include <mutex>
+
+uint32_t SymbolTable::intern(const std::string& ticker) {
+    uint32_t id;
+    if (find(ticker, id)) return id;
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = ids.find(ticker);
+    if (it != ids.end()) return it->second;
+    id = static_cast<uint32_t>(names.size());
+    ids.emplace(ticker, id);
+    names.push_back(ticker);
+    return id;
+}
+
+bool SymbolTable::find(const std::string& ticker, uint32_t& id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = ids.find(ticker);
+    if (it == ids.end()) return false;
+    id = it->second;
+    return true;
+}
+
+const std::string& SymbolTable::name(uint32_t id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return names[id];
+}
+
+size_t SymbolTable::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return names.size();
+}
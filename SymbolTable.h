@@ -0,0 +1,27 @@
+#ifndef SYMBOLTABLE_H
+#define SYMBOLTABLE_H
+
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+// Interns ticker symbols as dense 32-bit ids. Ids are handed out in
+// first-seen order and are never reused. A table is shared by a tree and
+// every read-only view of it, so lookups may run while another thread
+// interns; names live in a deque and stay put once added.
+class SymbolTable {
+private:
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string, uint32_t> ids;
+    std::deque<std::string> names;
+
+public:
+    uint32_t intern(const std::string& ticker);
+    bool find(const std::string& ticker, uint32_t& id) const;
+    const std::string& name(uint32_t id) const;
+    size_t size() const;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include "SyncState.h"
+#include "DateUtils.h"
+#include <cstdio>
+#include <fstream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Same order as Snapshot::write: the file's contents reach the disk
+    // before the rename that publishes them, and the rename itself is
+    // made durable through the directory.
+    bool syncFile(FILE* f) {
+        if (fflush(f) != 0) return false;
+#ifdef _WIN32
+        return _commit(_fileno(f)) == 0;
+#else
+        return fsync(fileno(f)) == 0;
+#endif
+    }
+
+    // Windows gets this from MOVEFILE_WRITE_THROUGH.
+    bool syncDirectoryOf(const std::string& path) {
+#ifdef _WIN32
+        (void)path;
+        return true;
+#else
+        size_t slash = path.find_last_of('/');
+        std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+        int dirFd = ::open(dir.c_str(), O_RDONLY);
+        if (dirFd < 0) return false;
+        bool ok = fsync(dirFd) == 0;
+        ::close(dirFd);
+        return ok;
+#endif
+    }
+}
+
+bool SyncState::load(const std::string& path) {
+    marks.clear();
+    std::ifstream file(path);
+    if (!file.is_open()) return true;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t comma = line.find(',');
+        int day;
+        if (comma == std::string::npos || !DateUtils::parseDate(line.substr(comma + 1), day)) {
+            if (line.empty()) continue;
+            marks.clear();
+            return false;
+        }
+        advance(line.substr(0, comma), day);
+    }
+    return true;
+}
+
+bool SyncState::save(const std::string& path) const {
+    std::string temp = path + ".tmp";
+    FILE* file = fopen(temp.c_str(), "w");
+    if (!file) return false;
+    bool ok = true;
+    for (const auto& mark : marks) {
+        ok = ok && fprintf(file, "%s,%s\n", mark.first.c_str(), DateUtils::toDateString(mark.second).c_str()) > 0;
+    }
+    ok = ok && syncFile(file);
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) {
+        std::remove(temp.c_str());
+        return false;
+    }
+#ifdef _WIN32
+    return MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(temp.c_str(), path.c_str()) == 0 && syncDirectoryOf(path);
+#endif
+}
+
+bool SyncState::get(const std::string& ticker, int& day) const {
+    auto it = marks.find(ticker);
+    if (it == marks.end()) return false;
+    day = it->second;
+    return true;
+}
+
+void SyncState::advance(const std::string& ticker, int day) {
+    auto it = marks.find(ticker);
+    if (it == marks.end()) marks.emplace(ticker, day);
+    else if (day > it->second) it->second = day;
+}
@@ -0,0 +1,27 @@
+#ifndef SYNCSTATE_H
+#define SYNCSTATE_H
+
+#include <map>
+#include <string>
+
+// Per-ticker high-water marks for incremental API sync: the newest day
+// already imported for each ticker. Stored as "TICKER,YYYY-MM-DD" lines
+// so it survives restarts and can be inspected by hand.
+class SyncState {
+private:
+    std::map<std::string, int> marks;
+
+public:
+    // A missing file is an empty state, not an error.
+    bool load(const std::string& path);
+    // Writes and syncs a temporary file, renames it over path and syncs
+    // the directory, so a crash never leaves a half-written state behind
+    // and a successful save survives one.
+    bool save(const std::string& path) const;
+
+    bool get(const std::string& ticker, int& day) const;
+    void advance(const std::string& ticker, int day);     // never moves a mark back
+    size_t size() const { return marks.size(); }
+};
+
+#endif
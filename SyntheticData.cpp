@@ -0,0 +1,81 @@
+#include "SyntheticData.h"
+#include "DateUtils.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// splitmix64: tiny, fast, and good enough for synthetic prices.
+struct Random {
+    uint64_t state;
+    explicit Random(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }     // [0, 1)
+
+    // Box-Muller; one of the pair is discarded to keep the stream simple.
+    double normal() {
+        double u1 = 1.0 - uniform();
+        double u2 = uniform();
+        return std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+    }
+};
+
+} // namespace
+
+SyntheticMarket::SyntheticMarket(const SyntheticConfig& config) : config(config) {
+    tradingDays.reserve(config.days);
+    for (int d = config.firstDay; tradingDays.size() < config.days; d++) {
+        int weekday = (d + 4) % 7;      // 1970-01-01 was a Thursday; 0 = Sunday
+        if (weekday != 0 && weekday != 6) tradingDays.push_back(d);
+    }
+}
+
+std::string SyntheticMarket::tickerName(size_t ticker) const {
+    // Base-26, at least four letters, so names sort in generation order
+    // for up to 26^4 tickers.
+    std::string name;
+    do {
+        name.push_back(static_cast<char>('A' + ticker % 26));
+        ticker /= 26;
+    } while (ticker > 0);
+    while (name.size() < 4) name.push_back('A');
+    std::reverse(name.begin(), name.end());
+    return name;
+}
+
+void SyntheticMarket::generate(size_t first, size_t count, std::vector<StockData>& out) const {
+    size_t last = std::min(first + count, config.tickers);
+    if (first >= last) return;
+    out.reserve(out.size() + (last - first) * tradingDays.size());
+
+    for (size_t t = first; t < last; t++) {
+        Random rng(config.seed ^ (0xD1B54A32D192ED03ull * (t + 1)));
+        std::string ticker = tickerName(t);
+        double price = 10.0 + 490.0 * rng.uniform();
+        double drift = 0.0004 * (rng.uniform() - 0.3);
+        double sigma = 0.008 + 0.025 * rng.uniform();
+        double baseVolume = 1e5 + 5e6 * rng.uniform();
+
+        for (int d : tradingDays) {
+            double open = price * std::exp(0.25 * sigma * rng.normal());
+            double close = open * std::exp(drift + sigma * rng.normal());
+            double high = std::max(open, close) * (1.0 + 0.5 * sigma * std::fabs(rng.normal()));
+            double low = std::min(open, close) * (1.0 - 0.5 * sigma * std::fabs(rng.normal()));
+            long volume = static_cast<long>(baseVolume * std::exp(0.4 * rng.normal()));
+            // Two decimals, like real quotes and the CSV round trip.
+            open = std::max(std::round(open * 100) / 100, 0.01);
+            close = std::max(std::round(close * 100) / 100, 0.01);
+            high = std::max(std::round(high * 100) / 100, std::max(open, close));
+            low = std::min(std::round(low * 100) / 100, std::min(open, close));
+            out.push_back(StockData(ticker, DateUtils::toDateString(d), open, close, high, low, volume));
+            price = close;
+        }
+    }
+}
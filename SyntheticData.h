@@ -0,0 +1,40 @@
+#ifndef SYNTHETICDATA_H
+#define SYNTHETICDATA_H
+
+#include "AVLTree.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct SyntheticConfig {
+    size_t tickers = 100;
+    size_t days = 2520;             // trading days per ticker (~10 years)
+    uint64_t seed = 42;
+    int firstDay = 10957;           // 2000-01-03, a Monday
+};
+
+// Deterministic OHLCV generator for tests and benchmarks. Each ticker is
+// a geometric random walk with its own drift and volatility, on weekdays
+// only. A ticker's rows depend only on (seed, ticker index), so any
+// slice can be regenerated without producing the ones before it, and
+// the output is the same on every platform (no std:: distributions).
+class SyntheticMarket {
+private:
+    SyntheticConfig config;
+    std::vector<int> tradingDays;
+
+public:
+    explicit SyntheticMarket(const SyntheticConfig& config);
+
+    size_t tickerCount() const { return config.tickers; }
+    size_t dayCount() const { return tradingDays.size(); }
+    size_t rowCount() const { return config.tickers * tradingDays.size(); }
+
+    std::string tickerName(size_t ticker) const;    // "AAAA", "AAAB", ...
+    int day(size_t index) const { return tradingDays[index]; }
+
+    // Appends every row of tickers [first, first + count) in key order.
+    void generate(size_t first, size_t count, std::vector<StockData>& out) const;
+};
+
+#endif
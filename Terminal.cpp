@@ -0,0 +1,39 @@
+#include "Terminal.h"
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace Terminal {
+    bool stdoutIsTerminal() {
+#ifdef _WIN32
+        return _isatty(_fileno(stdout)) != 0;
+#else
+        return isatty(STDOUT_FILENO) != 0;
+#endif
+    }
+
+    void clearScreen() {
+        static const bool enabled = [] {
+            if (!stdoutIsTerminal()) return false;
+#ifdef _WIN32
+            // Windows 10+ consoles understand ANSI once VT processing is on.
+            HANDLE out = GetStdHandle(STD_OUTPUT_HANDLE);
+            DWORD mode = 0;
+            if (!GetConsoleMode(out, &mode)) return false;
+            if (!(mode & ENABLE_VIRTUAL_TERMINAL_PROCESSING) &&
+                !SetConsoleMode(out, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING))
+                return false;
+#endif
+            return true;
+        }();
+        if (enabled) std::cout << "\033[2J\033[H" << std::flush;
+    }
+}
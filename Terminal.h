@@ -0,0 +1,11 @@
+#ifndef TERMINAL_H
+#define TERMINAL_H
+
+namespace Terminal {
+    bool stdoutIsTerminal();
+    // Clears an interactive console with ANSI escapes (no shell is
+    // spawned); does nothing when stdout is redirected.
+    void clearScreen();
+}
+
+#endif
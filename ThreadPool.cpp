@@ -0,0 +1,124 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <exception>
+
+namespace {
+    // Index of the pool worker running on this thread, or -1.
+    thread_local int currentWorker = -1;
+    thread_local const ThreadPool* currentPool = nullptr;
+}
+
+ThreadPool::ThreadPool(unsigned threads) : queued(0), nextQueue(0), stopping(false) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < threads; i++)
+        queues.push_back(std::unique_ptr<Queue>(new Queue()));
+    for (unsigned i = 0; i < threads; i++)
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& w : workers) w.join();
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    unsigned index = (currentPool == this && currentWorker >= 0)
+        ? static_cast<unsigned>(currentWorker)
+        : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    // Count first so a concurrent pop can never take queued below zero.
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queued++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::popLocal(unsigned index, std::function<void()>& task) {
+    Queue& q = *queues[index];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty()) return false;
+    task = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(unsigned thief, std::function<void()>& task) {
+    const unsigned n = static_cast<unsigned>(queues.size());
+    for (unsigned k = 1; k <= n; k++) {
+        Queue& q = *queues[(thief + k) % n];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (!q.tasks.empty()) {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::runOne() {
+    std::function<void()> task;
+    bool isWorker = currentPool == this && currentWorker >= 0;
+    unsigned self = isWorker ? static_cast<unsigned>(currentWorker) : 0;
+    if (!(isWorker && popLocal(self, task)) && !steal(self, task)) return false;
+    queued--;
+    task();
+    return true;
+}
+
+void ThreadPool::workerLoop(unsigned index) {
+    currentWorker = static_cast<int>(index);
+    currentPool = this;
+    while (true) {
+        if (runOne()) continue;
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0) return;
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) return;
+    if (count == 1 || workers.empty()) {
+        for (size_t i = 0; i < count; i++) body(i);
+        return;
+    }
+
+    // A few chunks per thread leaves room for stealing to even out skew.
+    const size_t chunks = std::min(count, static_cast<size_t>(size() + 1) * 4);
+    std::atomic<size_t> remaining(chunks);
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+
+    for (size_t c = 0; c < chunks; c++) {
+        submit([&, c] {
+            size_t first = count * c / chunks;
+            size_t last = count * (c + 1) / chunks;
+            try {
+                for (size_t i = first; i < last; i++) body(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(failureMutex);
+                if (!failure) failure = std::current_exception();
+            }
+            remaining.fetch_sub(1, std::memory_order_acq_rel);
+        });
+    }
+
+    while (remaining.load(std::memory_order_acquire) != 0) {
+        if (!runOne()) std::this_thread::yield();
+    }
+    if (failure) std::rethrow_exception(failure);
+}
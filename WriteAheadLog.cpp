@@ -0,0 +1,358 @@
+#include "WriteAheadLog.h"
+#include "DateUtils.h"
+#include "MappedFile.h"
+#include "Snapshot.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const char MAGIC[8] = { 'M', 'M', 'W', 'A', 'L', '\0', '\0', '1' };
+    const size_t FRAME_BYTES = 2 * sizeof(uint32_t);
+
+    static_assert(sizeof(WalRecordHeader) == 48, "log record layout changed");
+
+    // CRC-32 (IEEE 802.3, reflected), byte-at-a-time with a lookup table.
+    uint32_t crc32(const char* data, size_t size) {
+        static const std::vector<uint32_t> table = [] {
+            std::vector<uint32_t> t(256);
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[i] = c;
+            }
+            return t;
+        }();
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < size; i++)
+            crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    // Walks the log's frames from just past the magic and counts the
+    // intact ones; validBytes is where the first torn or corrupt one
+    // starts. Nothing is applied.
+    size_t scanLog(const char* data, size_t size, uint64_t& validBytes) {
+        size_t records = 0;
+        size_t pos = sizeof(MAGIC);
+        while (size - pos >= FRAME_BYTES) {
+            uint32_t length, crc;
+            memcpy(&length, data + pos, sizeof(length));
+            memcpy(&crc, data + pos + sizeof(length), sizeof(crc));
+            const char* payload = data + pos + FRAME_BYTES;
+            if (length < sizeof(WalRecordHeader) || length > size - pos - FRAME_BYTES) break;
+            if (crc32(payload, length) != crc) break;
+            WalRecordHeader h;
+            memcpy(&h, payload, sizeof(h));
+            if (sizeof(h) + h.tickerLength != length) break;
+            records++;
+            pos += FRAME_BYTES + length;
+        }
+        validBytes = pos;
+        return records;
+    }
+
+    bool fileExists(const std::string& path) {
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f) return false;
+        fclose(f);
+        return true;
+    }
+
+    // Makes a rename in the snapshot's directory durable. Windows does
+    // this through MOVEFILE_WRITE_THROUGH in Snapshot::write.
+    bool syncDirectoryOf(const std::string& path) {
+#ifdef _WIN32
+        (void)path;
+        return true;
+#else
+        size_t slash = path.find_last_of('/');
+        std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+        int dirFd = ::open(dir.c_str(), O_RDONLY);
+        if (dirFd < 0) return false;
+        bool ok = fsync(dirFd) == 0;
+        ::close(dirFd);
+        return ok;
+#endif
+    }
+}
+
+#ifdef _WIN32
+WriteAheadLog::WriteAheadLog()
+    : tree(nullptr), handle(INVALID_HANDLE_VALUE), appended(0), durable(0), flushing(false),
+      failed(false), checkpointBytes(DEFAULT_CHECKPOINT_BYTES) {}
+#else
+WriteAheadLog::WriteAheadLog()
+    : tree(nullptr), fd(-1), appended(0), durable(0), flushing(false),
+      failed(false), checkpointBytes(DEFAULT_CHECKPOINT_BYTES) {}
+#endif
+
+WriteAheadLog::~WriteAheadLog() {
+    close();
+}
+
+#ifdef _WIN32
+bool WriteAheadLog::openFile(std::string& error) {
+    handle = CreateFileA(logPath.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                         OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        error = "cannot open " + logPath;
+        return false;
+    }
+    LARGE_INTEGER zero = {};
+    SetFilePointerEx(handle, zero, nullptr, FILE_END);
+    return true;
+}
+
+void WriteAheadLog::closeFile() {
+    if (handle != INVALID_HANDLE_VALUE) CloseHandle(handle);
+    handle = INVALID_HANDLE_VALUE;
+}
+
+bool WriteAheadLog::writeAndSync(const std::vector<char>& bytes) {
+    size_t done = 0;
+    while (done < bytes.size()) {
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(bytes.size() - done, 1u << 30));
+        DWORD written = 0;
+        if (!WriteFile(handle, bytes.data() + done, chunk, &written, nullptr) || written == 0) return false;
+        done += written;
+    }
+    return FlushFileBuffers(handle) != 0;
+}
+
+bool WriteAheadLog::truncateTo(uint64_t size) {
+    LARGE_INTEGER pos;
+    pos.QuadPart = static_cast<LONGLONG>(size);
+    return SetFilePointerEx(handle, pos, nullptr, FILE_BEGIN) && SetEndOfFile(handle) &&
+           FlushFileBuffers(handle);
+}
+#else
+bool WriteAheadLog::openFile(std::string& error) {
+    fd = ::open(logPath.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        error = "cannot open " + logPath;
+        return false;
+    }
+    return true;
+}
+
+void WriteAheadLog::closeFile() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+bool WriteAheadLog::writeAndSync(const std::vector<char>& bytes) {
+    size_t done = 0;
+    while (done < bytes.size()) {
+        ssize_t n = ::write(fd, bytes.data() + done, bytes.size() - done);
+        if (n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    return fsync(fd) == 0;
+}
+
+bool WriteAheadLog::truncateTo(uint64_t size) {
+    return ftruncate(fd, static_cast<off_t>(size)) == 0 && fsync(fd) == 0;
+}
+#endif
+
+// Applies the frames scanLog() accepted, so checksums are not recomputed.
+size_t WriteAheadLog::replay(const char* data, uint64_t validBytes) {
+    size_t applied = 0;
+    size_t pos = sizeof(MAGIC);
+    while (pos < validBytes) {
+        uint32_t length;
+        memcpy(&length, data + pos, sizeof(length));
+        const char* payload = data + pos + FRAME_BYTES;
+        WalRecordHeader h;
+        memcpy(&h, payload, sizeof(h));
+
+        std::string ticker(payload + sizeof(h), h.tickerLength);
+        std::string date = DateUtils::toDateString(h.day);
+        if (static_cast<MutationKind>(h.kind) == MutationKind::Remove) {
+            tree->remove(ticker, date);
+        } else {
+            StockData row(ticker, date, h.openPrice, h.closePrice, h.highPrice, h.lowPrice,
+                          static_cast<long>(h.volume));
+            if (!tree->update(row)) tree->insert(row);
+        }
+        applied++;
+        pos += FRAME_BYTES + length;
+    }
+    return applied;
+}
+
+bool WriteAheadLog::open(AVLTree& target, const std::string& snapshotFile, const std::string& logFile,
+                         WalRecovery& recovery, std::string& error) {
+    close();
+    snapshotPath = snapshotFile;
+    logPath = logFile;
+    recovery = WalRecovery();
+
+    // Every step that can fail runs before `target` is touched, so a
+    // failed open leaves it exactly as it was.
+    Snapshot snapshot;
+    bool haveSnapshot = fileExists(snapshotPath);
+    if (haveSnapshot && !snapshot.open(snapshotPath, true, error)) return false;
+
+    uint64_t fileBytes = 0, validBytes = 0;
+    size_t records = 0;
+    if (fileExists(logPath)) {
+        MappedFile log;
+        if (!log.open(logPath)) {
+            error = "cannot open " + logPath;
+            return false;
+        }
+        fileBytes = log.size();
+        if (fileBytes >= sizeof(MAGIC)) {
+            if (memcmp(log.data(), MAGIC, sizeof(MAGIC)) != 0) {
+                error = logPath + " is not a write-ahead log";
+                return false;
+            }
+            records = scanLog(log.data(), log.size(), validBytes);
+        }
+    }
+
+    if (!openFile(error)) return false;
+    bool ok = true;
+    if (validBytes < sizeof(MAGIC)) {
+        // Missing, empty, or cut off while being created
+        std::vector<char> magic(MAGIC, MAGIC + sizeof(MAGIC));
+        ok = truncateTo(0) && writeAndSync(magic);
+        validBytes = sizeof(MAGIC);
+    } else if (validBytes < fileBytes) {
+        ok = truncateTo(validBytes);
+    }
+    // Mapped again after the cut: Windows cannot shorten a mapped file.
+    MappedFile log;
+    if (ok && records > 0 && !log.open(logPath)) ok = false;
+    if (!ok) {
+        closeFile();
+        error = "cannot write " + logPath;
+        return false;
+    }
+
+    tree = &target;
+    if (haveSnapshot) recovery.snapshotRows = snapshot.loadInto(target);
+    if (records > 0) recovery.replayedRecords = replay(log.data(), std::min<uint64_t>(validBytes, log.size()));
+    recovery.discardedBytes = fileBytes > validBytes ? fileBytes - validBytes : 0;
+    counters.logBytes = validBytes;
+    tree->addListener(this);
+    return true;
+}
+
+void WriteAheadLog::close() {
+    if (!tree) return;
+    tree->removeListener(this);
+    commit();
+    closeFile();
+    tree = nullptr;
+}
+
+void WriteAheadLog::onMutation(const std::string& ticker, int day, MutationKind kind) {
+    WalRecordHeader h = {};
+    h.kind = static_cast<uint8_t>(kind);
+    h.tickerLength = static_cast<uint16_t>(std::min<size_t>(ticker.size(), UINT16_MAX));
+    h.day = day;
+    if (kind != MutationKind::Remove) {
+        StockBar bar;
+        if (!tree->searchBar(ticker, day, bar)) return;
+        h.openPrice = bar.openPrice;
+        h.closePrice = bar.closePrice;
+        h.highPrice = bar.highPrice;
+        h.lowPrice = bar.lowPrice;
+        h.volume = bar.volume;
+    }
+
+    uint32_t length = static_cast<uint32_t>(sizeof(h) + h.tickerLength);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t at = pending.size();
+    pending.resize(at + FRAME_BYTES + length);
+    char* payload = &pending[at + FRAME_BYTES];
+    memcpy(payload, &h, sizeof(h));
+    memcpy(payload + sizeof(h), ticker.data(), h.tickerLength);
+    uint32_t crc = crc32(payload, length);
+    memcpy(&pending[at], &length, sizeof(length));
+    memcpy(&pending[at + sizeof(length)], &crc, sizeof(crc));
+    appended++;
+}
+
+bool WriteAheadLog::commit() {
+    std::unique_lock<std::mutex> lock(mutex);
+    const uint64_t target = appended;
+    while (durable < target && !failed) {
+        if (flushing) {
+            // Another caller is flushing; its fsync or the next one covers us
+            flushed.wait(lock);
+            continue;
+        }
+        flushing = true;
+        std::vector<char> batch;
+        batch.swap(pending);
+        const uint64_t batchEnd = appended;
+        lock.unlock();
+        bool ok = writeAndSync(batch);
+        lock.lock();
+        flushing = false;
+        if (ok) {
+            counters.records += batchEnd - durable;
+            counters.commits++;
+            counters.logBytes += batch.size();
+            durable = batchEnd;
+        } else {
+            failed = true;
+        }
+        flushed.notify_all();
+    }
+    return !failed;
+}
+
+bool WriteAheadLog::checkpoint(std::string& error) {
+    std::unique_lock<std::mutex> lock(mutex);
+    flushed.wait(lock, [this] { return !flushing; });
+    if (!tree || failed) {
+        error = failed ? "an earlier log write failed" : "write-ahead log is not open";
+        return false;
+    }
+    // The snapshot covers every buffered record, so once it and its
+    // directory entry are durable the log can start over.
+    if (!Snapshot::write(*tree, snapshotPath, error)) return false;
+    if (!syncDirectoryOf(snapshotPath)) {
+        error = "cannot sync the directory of " + snapshotPath;
+        return false;
+    }
+    if (!truncateTo(sizeof(MAGIC))) {
+        failed = true;
+        error = "cannot truncate " + logPath;
+        return false;
+    }
+    pending.clear();
+    durable = appended;
+    counters.logBytes = sizeof(MAGIC);
+    counters.checkpoints++;
+    flushed.notify_all();
+    return true;
+}
+
+bool WriteAheadLog::needsCheckpoint() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters.logBytes + pending.size() >= checkpointBytes;
+}
+
+WalStats WriteAheadLog::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
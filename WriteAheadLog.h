@@ -0,0 +1,105 @@
+#ifndef WRITEAHEADLOG_H
+#define WRITEAHEADLOG_H
+
+#include "AVLTree.h"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Log layout (native byte order): an 8-byte magic, then records back to
+// back:
+//   uint32_t length                 payload bytes
+//   uint32_t crc                    CRC-32 of the payload
+//   WalRecordHeader, ticker bytes   payload
+// Records hold the row's full new value (prices are zero for removals),
+// so replaying a record twice is harmless.
+struct WalRecordHeader {
+    uint8_t kind;                   // MutationKind
+    uint8_t reserved;
+    uint16_t tickerLength;
+    int32_t day;
+    double openPrice;
+    double closePrice;
+    double highPrice;
+    double lowPrice;
+    int64_t volume;
+};
+
+struct WalRecovery {
+    size_t snapshotRows = 0;
+    size_t replayedRecords = 0;
+    uint64_t discardedBytes = 0;    // torn or corrupt tail left by a crash
+};
+
+struct WalStats {
+    uint64_t records = 0;
+    uint64_t commits = 0;           // durable flushes, each covering one or more records
+    uint64_t checkpoints = 0;
+    uint64_t logBytes = 0;          // current log size
+};
+
+// Durability for an AVLTree: the last checkpoint snapshot plus a log of
+// every mutation since. Attached as a tree listener, it encodes each
+// insert/update/remove into a memory buffer; commit() writes everything
+// buffered with one sequential append and one fsync. Concurrent commit()
+// calls are grouped: one caller flushes while the others wait and are
+// covered by the same fsync. A change is durable once commit() returns.
+class WriteAheadLog : public TreeListener {
+private:
+    AVLTree* tree;
+    std::string snapshotPath;
+    std::string logPath;
+#ifdef _WIN32
+    void* handle;
+#else
+    int fd;
+#endif
+    mutable std::mutex mutex;
+    std::condition_variable flushed;
+    std::vector<char> pending;      // encoded records not yet written
+    uint64_t appended;              // records encoded so far
+    uint64_t durable;               // records known to be on disk
+    bool flushing;
+    bool failed;
+    uint64_t checkpointBytes;
+    WalStats counters;
+
+    bool openFile(std::string& error);
+    void closeFile();
+    bool writeAndSync(const std::vector<char>& bytes);
+    bool truncateTo(uint64_t size);
+    size_t replay(const char* data, uint64_t validBytes);
+
+public:
+    static const uint64_t DEFAULT_CHECKPOINT_BYTES = 64ull << 20;
+
+    WriteAheadLog();
+    ~WriteAheadLog();
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // Recovery: checks the snapshot (if any) and the log, cuts off a torn
+    // tail, then loads the snapshot into `tree`, replays the log on top
+    // of it and starts recording the tree's mutations. Either file may be
+    // missing on first run. On failure `tree` is left untouched.
+    bool open(AVLTree& tree, const std::string& snapshotPath, const std::string& logPath,
+              WalRecovery& recovery, std::string& error);
+    void close();
+
+    bool commit();
+
+    // Compaction: writes a fresh snapshot of the tree, then empties the
+    // log. The tree must not change while this runs.
+    bool checkpoint(std::string& error);
+    void setCheckpointBytes(uint64_t bytes) { checkpointBytes = bytes; }
+    bool needsCheckpoint() const;
+
+    WalStats stats() const;
+
+    void onMutation(const std::string& ticker, int day, MutationKind kind) override;
+    bool wantsEveryRow() const override { return true; }
+};
+
+#endif
@@ -1,286 +1,724 @@
-#include "AVLTree.h"
-#include "FinancialMetrics.h"
-#include "ImportStockData.h"
-#include <iostream>
-#include <iomanip>
-#include <fstream>
-#include <sstream>
-#include <vector>
-#include <algorithm>
-#include <limits>
-
-void displayMenu() {
-    std::cout << "===== Stock Market Data Analyzer =====\n";
-    std::cout << "1.  Import stock data from API\n";
-    std::cout << "2.  Import stock data from CSV\n";
-    std::cout << "3.  Search for a stock\n";
-    std::cout << "4.  Update stock data\n";
-    std::cout << "5.  Remove stock data\n";
-    std::cout << "6.  Display all stocks\n";
-    std::cout << "7.  Display stocks by ticker\n";
-    std::cout << "8.  Display stocks by date range\n";
-    std::cout << "9.  Export to CSV\n";
-    std::cout << "10. Compare multiple stocks\n";
-    std::cout << "11. Calculate financial metrics\n";
-    std::cout << "12. Simulate trade\n";
-    std::cout << "13. Exit\n";
-    std::cout << "Enter your choice (1-13): ";
-}
-
-StockData inputStockData() {
-    StockData data;
-    std::cout << "Enter ticker symbol: ";
-    std::cin >> data.ticker;
-    std::cout << "Enter date (YYYY-MM-DD): ";
-    std::cin >> data.date;
-    std::cout << "Enter opening price: ";
-    std::cin >> data.openPrice;
-    std::cout << "Enter closing price: ";
-    std::cin >> data.closePrice;
-    std::cout << "Enter highest price: ";
-    std::cin >> data.highPrice;
-    std::cout << "Enter lowest price: ";
-    std::cin >> data.lowPrice;
-    std::cout << "Enter volume: ";
-    std::cin >> data.volume;
-    return data;
-}
-
-void displayStock(const StockData &stock) {
-    std::cout << "Ticker: " << stock.ticker << " | Date: " << stock.date << "\n";
-    std::cout << "Open: $" << std::fixed << std::setprecision(2) << stock.openPrice;
-    std::cout << " | Close: $" << stock.closePrice;
-    std::cout << " | High: $" << stock.highPrice;
-    std::cout << " | Low: $" << stock.lowPrice;
-    std::cout << " | Volume: " << stock.volume << "\n\n";
-}
-
-void exportDataAsCSV(AVLTree stockTree) {
-    std::ofstream outFile("stocks.csv");
-    if (outFile.is_open()) {
-        outFile << "Ticker,Date,Open,Close,High,Low,Volume\n";
-        std::vector<StockData> allStocks = stockTree.getAllStocks();
-        for (const auto &stock : allStocks) {
-            outFile << stock.ticker << "," << stock.date << ","
-                    << stock.openPrice << "," << stock.closePrice << ","
-                    << stock.highPrice << "," << stock.lowPrice << ","
-                    << stock.volume << "\n";
-        }
-        outFile.close();
-        std::cout << "Data exported to stocks.csv successfully.\n";
-    } else {
-        std::cout << "Error opening file for export.\n";
-    }
-}
-
-void importDataFromCSV(AVLTree& stockTree, const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cout << "Error opening file: " << filename << std::endl;
-        return;
-    }
-    std::string line;
-    std::getline(file, line); // Skip header
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        StockData data;
-        std::string temp;
-        std::getline(ss, data.ticker, ',');
-        std::getline(ss, data.date, ',');
-        std::getline(ss, temp, ','); data.openPrice = std::stod(temp);
-        std::getline(ss, temp, ','); data.closePrice = std::stod(temp);
-        std::getline(ss, temp, ','); data.highPrice = std::stod(temp);
-        std::getline(ss, temp, ','); data.lowPrice = std::stod(temp);
-        std::getline(ss, temp, ','); data.volume = std::stol(temp);
-        stockTree.insert(data);
-    }
-    std::cout << "CSV data imported successfully!\n";
-    file.close();
-}
-
-int main() {
-    AVLTree stockTree;
-    int choice;
-    while (true) {
-        displayMenu();
-        std::cin >> choice;
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-
-        switch (choice) {
-            case 1: {
-                std::string ticker;
-                std::cout << "Enter ticker symbol: ";
-                std::getline(std::cin, ticker);
-                importData(stockTree, ticker); // Import data from API
-                break;
-            }
-            case 2: {
-                std::string filename;
-                std::cout << "Enter CSV filename (e.g. stocks.csv): ";
-                std::getline(std::cin, filename);
-                importDataFromCSV(stockTree, filename);
-                break;
-            }
-            case 3: {
-                std::string ticker, date;
-                std::cout << "Enter ticker symbol: ";
-                std::getline(std::cin, ticker);
-                std::cout << "Enter date (YYYY-MM-DD): ";
-                std::getline(std::cin, date);
-                StockData* stock = stockTree.search(ticker, date);
-                if (stock) {
-                    std::cout << "\nStock found:\n";
-                    displayStock(*stock);
-                } else {
-                    std::cout << "Stock not found!\n";
-                }
-                break;
-            }
-            case 4: {
-                StockData updatedStock = inputStockData();
-                if (stockTree.update(updatedStock)) {
-                    std::cout << "Stock data updated successfully.\n";
-                } else {
-                    std::cout << "Stock not found. Update failed.\n";
-                }
-                break;
-            }
-            case 5: {
-                std::string ticker, date;
-                std::cout << "Enter ticker symbol to remove: ";
-                std::getline(std::cin, ticker);
-                std::cout << "Enter date (YYYY-MM-DD) to remove: ";
-                std::getline(std::cin, date);
-                if (stockTree.remove(ticker, date)) {
-                    std::cout << "Stock data removed successfully.\n";
-                } else {
-                    std::cout << "Stock not found. Removal failed.\n";
-                }
-                break;
-            }
-            case 6: {
-                std::vector<StockData> allStocks = stockTree.getAllStocks();
-                std::cout << "\nAll stocks (" << allStocks.size() << " entries):\n";
-                for (const auto &stock : allStocks) {
-                    displayStock(stock);
-                }
-                break;
-            }
-            case 7: {
-                std::string ticker;
-                std::cout << "Enter ticker symbol: ";
-                std::getline(std::cin, ticker);
-                std::vector<StockData> tickerStocks = stockTree.getStocksByTicker(ticker);
-                std::cout << "\nFound " << tickerStocks.size() << " entries for " << ticker << ":\n";
-                for (const auto &stock : tickerStocks) {
-                    displayStock(stock);
-                }
-                break;
-            }
-            case 8: {
-                std::string ticker, startDate, endDate;
-                std::cout << "Enter ticker symbol: ";
-                std::getline(std::cin, ticker);
-                std::cout << "Enter start date (YYYY-MM-DD): ";
-                std::getline(std::cin, startDate);
-                std::cout << "Enter end date (YYYY-MM-DD): ";
-                std::getline(std::cin, endDate);
-                std::vector<StockData> rangeStocks = stockTree.getStocksByDateRange(ticker, startDate, endDate);
-                std::cout << "\nFound " << rangeStocks.size() << " entries between " 
-                          << startDate << " and " << endDate << ":\n";
-                for (const auto &stock : rangeStocks) {
-                    displayStock(stock);
-                }
-                break;
-            }
-            case 9:
-                exportDataAsCSV(stockTree);
-                break;
-            case 10: {
-                std::vector<std::string> tickers;
-                std::string input;
-                std::cout << "Enter tickers (comma-separated): ";
-                std::getline(std::cin, input);
-                size_t pos;
-                while ((pos = input.find(',')) != std::string::npos) {
-                    tickers.push_back(input.substr(0, pos));
-                    input.erase(0, pos + 1);
-                }
-                tickers.push_back(input);
-                auto stocks = stockTree.getMultipleTickers(tickers);
-                std::cout << "\nComparison Table:\n";
-                printf("%-10s %-12s %-8s %-8s %-8s\n", 
-                       "Ticker", "Date", "Close", "SMA(20)", "Volatility");
-                for (const auto &s : stocks) {
-                    auto tickerStocks = stockTree.getStocksByTicker(s.ticker);
-                    printf("%-10s %-12s %-8.2f %-8.2f %-8.2f\n", 
-                           s.ticker.c_str(), s.date.c_str(), 
-                           s.closePrice, 
-                           FinancialMetrics::calculateSMA(tickerStocks, 20),
-                           FinancialMetrics::calculateVolatility(tickerStocks));
-                }
-                break;
-            }
-            case 11: {
-                std::string ticker;
-                std::cout << "Enter ticker symbol: ";
-                std::getline(std::cin, ticker);
-                auto stocks = stockTree.getStocksByTicker(ticker);
-                if (!stocks.empty()) {
-                    std::cout << "\nFinancial Metrics for " << ticker << ":\n";
-                    std::cout << "20-day SMA: " << FinancialMetrics::calculateSMA(stocks, 20) << "\n";
-                    std::cout << "50-day EMA: " << FinancialMetrics::calculateEMA(stocks, 50) << "\n";
-                    std::cout << "30-day Volatility: " << FinancialMetrics::calculateVolatility(stocks) << "\n";
-                } else {
-                    std::cout << "No data found for " << ticker << "\n";
-                }
-                break;
-            }
-            case 12: {
-                std::string ticker, date;
-                char action;
-                int quantity;
-                std::cout << "Enter ticker symbol: ";
-                std::getline(std::cin, ticker);
-                std::cout << "Enter trade date (YYYY-MM-DD): ";
-                std::getline(std::cin, date);
-                std::cout << "Buy (B) or Sell (S): ";
-                std::cin >> action;
-                std::cout << "Enter quantity: ";
-                std::cin >> quantity;
-                std::cin.ignore();
-
-                StockData* stock = stockTree.search(ticker, date);
-                if (stock) {
-                    double total = stock->closePrice * quantity;
-                    double commission = std::max(5.0, total * 0.01);
-                    std::cout << "\nTrade Simulation Results:\n";
-                    std::cout << "---------------------------------\n";
-                    std::cout << "Ticker:        " << stock->ticker << "\n";
-                    std::cout << "Date:          " << stock->date << "\n";
-                    std::cout << "Price:         $" << stock->closePrice << "\n";
-                    std::cout << "Quantity:      " << quantity << "\n";
-                    std::cout << "Commission:    $" << commission << "\n";
-                    std::cout << "Net " << (toupper(action) == 'B' ? "Cost" : "Proceeds") 
-                              << ":    $" << total + commission << "\n";
-                } else {
-                    std::cout << "Stock not found for trade simulation\n";
-                }
-                break;
-            }
-            case 13:
-                std::cout << "Exiting program...\n";
-                return 0;
-            default:
-                std::cout << "Invalid choice. Please try again.\n";
-        }
-        std::cout << "\nPress Enter to continue...";
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-        #ifdef _WIN32
-                system("cls");
-        #else
-                system("clear");
-        #endif
-    }
-    return 0;
-}
+#include "AVLTree.h"
+#include "ConcurrentStore.h"
+#include "FinancialMetrics.h"
+#include "Indicators.h"
+#include "Comparison.h"
+#include "DateUtils.h"
+#include "CsvLoader.h"
+#include "Snapshot.h"
+#include "CsvExporter.h"
+#include "MetricsCache.h"
+#include "Resampler.h"
+#include "ImportStockData.h"
+#include "Benchmark.h"
+#include "BatchRunner.h"
+#include "Terminal.h"
+#include "Backtest.h"
+#include "Correlation.h"
+#include "Screener.h"
+#include "WriteAheadLog.h"
+#include "Instrumentation.h"
+#include "SelfTest.h"
+#include "SeriesStore.h"
+#include "CompressedStore.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <climits>
+
+void displayMenu() {
+    std::cout << "===== Stock Market Data Analyzer =====\n";
+    std::cout << "1.  Import stock data from API\n";
+    std::cout << "2.  Import stock data from CSV\n";
+    std::cout << "3.  Search for a stock\n";
+    std::cout << "4.  Update stock data\n";
+    std::cout << "5.  Remove stock data\n";
+    std::cout << "6.  Display all stocks\n";
+    std::cout << "7.  Display stocks by ticker\n";
+    std::cout << "8.  Display stocks by date range\n";
+    std::cout << "9.  Export to CSV\n";
+    std::cout << "10. Compare multiple stocks\n";
+    std::cout << "11. Calculate financial metrics\n";
+    std::cout << "12. Simulate trade\n";
+    std::cout << "13. Save binary snapshot\n";
+    std::cout << "14. Load binary snapshot\n";
+    std::cout << "15. Sync new stock data from API\n";
+    std::cout << "16. Backtest trading strategies\n";
+    std::cout << "17. Show store metrics\n";
+    std::cout << "18. Show weekly/monthly bars\n";
+    std::cout << "19. Correlation matrix\n";
+    std::cout << "20. Screen top movers\n";
+    std::cout << "21. Exit\n";
+    std::cout << "Enter your choice (1-21): ";
+}
+
+StockData inputStockData() {
+    StockData data;
+    std::cout << "Enter ticker symbol: ";
+    std::cin >> data.ticker;
+    std::cout << "Enter date (YYYY-MM-DD): ";
+    std::cin >> data.date;
+    std::cout << "Enter opening price: ";
+    std::cin >> data.openPrice;
+    std::cout << "Enter closing price: ";
+    std::cin >> data.closePrice;
+    std::cout << "Enter highest price: ";
+    std::cin >> data.highPrice;
+    std::cout << "Enter lowest price: ";
+    std::cin >> data.lowPrice;
+    std::cout << "Enter volume: ";
+    std::cin >> data.volume;
+    return data;
+}
+
+void displayStock(const StockData &stock) {
+    std::cout << "Ticker: " << stock.ticker << " | Date: " << stock.date << "\n";
+    std::cout << "Open: $" << std::fixed << std::setprecision(2) << stock.openPrice;
+    std::cout << " | Close: $" << stock.closePrice;
+    std::cout << " | High: $" << stock.highPrice;
+    std::cout << " | Low: $" << stock.lowPrice;
+    std::cout << " | Volume: " << stock.volume << "\n\n";
+}
+
+std::vector<std::string> splitTickers(std::string input) {
+    std::vector<std::string> tickers;
+    size_t pos;
+    while ((pos = input.find(',')) != std::string::npos) {
+        tickers.push_back(input.substr(0, pos));
+        input.erase(0, pos + 1);
+    }
+    tickers.push_back(input);
+    return tickers;
+}
+
+// Durable state for the interactive session: the last checkpoint and
+// every change logged since. Both are restored on startup.
+const char* const JOURNAL_SNAPSHOT = "market.snap";
+const char* const JOURNAL_LOG = "market.wal";
+
+// Makes every change so far durable, then folds the log into a new
+// snapshot once it has grown past the checkpoint size. The checkpoint
+// holds the writer lock so the log and snapshot stay in step. Returns
+// false if the changes could not be saved; a failed checkpoint only
+// warns, since the log already holds them.
+bool persistChanges(WriteAheadLog& journal, ConcurrentStore& store) {
+    std::string error;
+    bool checkpointed = true;
+    if (!journal.commit()) {
+        std::cout << "Warning: could not write " << JOURNAL_LOG << "; recent changes are not saved.\n";
+        return false;
+    }
+    if (journal.needsCheckpoint()) {
+        store.write([&](AVLTree&) { checkpointed = journal.checkpoint(error); });
+        if (!checkpointed) std::cout << "Warning: checkpoint failed: " << error << "\n";
+    }
+    return true;
+}
+
+// Reports a background import once it has finished and makes its rows
+// durable. False while it is still running or if none was started.
+bool finishImport(ImportJob& importJob, WriteAheadLog& journal, ConcurrentStore& store) {
+    ApiImportResult result;
+    bool incremental;
+    if (!importJob.collect(result, incremental)) return false;
+    std::cout << (incremental ? "Background sync finished: " : "Background import finished: ");
+    reportImport(result, incremental);
+    persistChanges(journal, store);
+    return true;
+}
+
+void exportDataAsCSV(const AVLTree& stockTree, const CsvExportFilter& filter) {
+    size_t rows;
+    if (CsvExporter::exportFile(stockTree, "stocks.csv", filter, rows)) {
+        std::cout << "Data exported to stocks.csv successfully (" << rows << " rows).\n";
+    } else {
+        std::cout << "Error opening file for export.\n";
+    }
+}
+
+void importDataFromCSV(ConcurrentStore& store, const std::string& filename) {
+    CsvLoadResult result;
+    bool opened = false;
+    store.write([&](AVLTree& tree) { opened = CsvLoader::importFile(tree, filename, result); });
+    if (!opened) {
+        std::cout << "Error opening file: " << filename << std::endl;
+        return;
+    }
+    for (const auto &error : result.errors) {
+        std::cout << "Skipped line " << error.line << ": " << error.reason << "\n";
+    }
+    if (result.errorCount > result.errors.size()) {
+        std::cout << "... and " << result.errorCount - result.errors.size() << " more malformed rows\n";
+    }
+    std::cout << "CSV data imported successfully! (" << result.rows.size() << " rows)\n";
+}
+
+// "--bench [options]" runs the benchmark suite instead of the menu.
+int runBenchMode(int argc, char* argv[]) {
+    BenchConfig config;
+    std::string outPath, error;
+    if (!parseBenchArgs(argc, argv, config, outPath, error)) {
+        std::cerr << error << "\nusage: --bench [--tickers N] [--days N] [--seed N] [--queries N] "
+                     "[--chunk-rows N] [--scratch DIR] [--out FILE] [--skip-insert] [--skip-csv]\n";
+        return 2;
+    }
+    std::ofstream file;
+    if (!outPath.empty()) {
+        file.open(outPath);
+        if (!file.is_open()) {
+            std::cerr << "Cannot write " << outPath << "\n";
+            return 1;
+        }
+    }
+    if (!runBenchmarks(config, outPath.empty() ? std::cout : file, error)) {
+        std::cerr << "Benchmark failed: " << error << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// "--batch [FILE|-] [--format csv|json] [--out FILE]
+// [--store tree|columns|compressed] [--snapshot FILE]" runs a command script (stdin by default) headlessly,
+// optionally starting from a binary snapshot; see BatchRunner.h.
+int runBatchMode(int argc, char* argv[]) {
+    BatchOptions options;
+    std::string scriptPath = "-", outPath, storeKind = "tree", snapshotPath;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc) {
+            std::string format = argv[++i];
+            if (format == "json") options.format = BatchFormat::Json;
+            else if (format != "csv") {
+                std::cerr << "Unknown format: " << format << "\n";
+                return 2;
+            }
+        }
+        else if (arg == "--out" && i + 1 < argc) outPath = argv[++i];
+        else if (arg == "--snapshot" && i + 1 < argc) snapshotPath = argv[++i];
+        else if (arg == "--store" && i + 1 < argc) {
+            storeKind = argv[++i];
+            if (storeKind != "tree" && storeKind != "columns" && storeKind != "compressed") {
+                std::cerr << "Unknown store: " << storeKind << "\n";
+                return 2;
+            }
+        }
+        else if (i == 2 && arg.compare(0, 2, "--") != 0) scriptPath = arg;
+        else {
+            std::cerr << "usage: --batch [FILE|-] [--format csv|json] [--out FILE] [--store tree|columns|compressed] [--snapshot FILE]\n";
+            return 2;
+        }
+    }
+
+    std::ifstream scriptFile;
+    if (scriptPath != "-") {
+        scriptFile.open(scriptPath);
+        if (!scriptFile.is_open()) {
+            std::cerr << "Cannot open " << scriptPath << "\n";
+            return 1;
+        }
+    }
+    std::ofstream outFile;
+    if (!outPath.empty()) {
+        outFile.open(outPath);
+        if (!outFile.is_open()) {
+            std::cerr << "Cannot write " << outPath << "\n";
+            return 1;
+        }
+    }
+    ApiImportConfig apiConfig;
+    if (loadApiConfig("config.txt", apiConfig)) options.api = &apiConfig;
+
+    AVLTree stockTree;
+    SeriesStore columns;
+    CompressedStore compressed;
+    if (storeKind == "columns") options.store = &columns;
+    else if (storeKind == "compressed") options.store = &compressed;
+    Snapshot snapshot;
+    if (!snapshotPath.empty()) {
+        std::string error;
+        if (!snapshot.open(snapshotPath, true, error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        options.snapshot = &snapshot;
+    }
+    BatchStats stats;
+    bool ok = runBatch(stockTree, scriptPath == "-" ? std::cin : scriptFile,
+                       outPath.empty() ? std::cout : outFile, options, stats);
+    printBatchStats(stats, std::cerr);
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") return runBenchMode(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "--batch") return runBatchMode(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "--selftest") return runSelfTests(std::cout) == 0 ? 0 : 1;
+
+    // Menu commands read the latest snapshot, so they keep working while
+    // an API import or sync publishes batches from its own thread.
+    ConcurrentStore store;
+    MetricsCache metricsCache(store);
+    ResampleCache barLevels(store);
+    ApiImportConfig apiConfig;
+    bool apiConfigured = loadApiConfig("config.txt", apiConfig);
+
+    WriteAheadLog journal;
+    WalRecovery recovery;
+    std::string journalError;
+    bool journalOpen = false;
+    store.write([&](AVLTree& tree) {
+        journalOpen = journal.open(tree, JOURNAL_SNAPSHOT, JOURNAL_LOG, recovery, journalError);
+    });
+    ImportJob importJob;
+    if (!journalOpen) {
+        std::cout << "Warning: changes will not be saved (" << journalError << ").\n";
+    } else if (recovery.snapshotRows > 0 || recovery.replayedRecords > 0) {
+        std::cout << "Restored " << recovery.snapshotRows << " rows from " << JOURNAL_SNAPSHOT
+                  << " and replayed " << recovery.replayedRecords << " logged changes.\n";
+    }
+    if (recovery.discardedBytes > 0) {
+        std::cout << "Discarded " << recovery.discardedBytes << " bytes of an incomplete log write.\n";
+    }
+
+    int choice;
+    while (true) {
+        if (finishImport(importJob, journal, store)) {
+            std::cout << "\n";
+        } else if (importJob.running()) {
+            std::cout << "(An API import is running; results so far are already searchable.)\n";
+        }
+        displayMenu();
+        std::cin >> choice;
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+        std::shared_ptr<const AVLTree> version = store.snapshot();
+        const AVLTree& stockTree = *version;
+        switch (choice) {
+            case 1: {
+                if (!apiConfigured) {
+                    std::cout << "No API_KEY found in config.txt.\n";
+                    break;
+                }
+                finishImport(importJob, journal, store);
+                if (importJob.running()) {
+                    std::cout << "An API import is already running.\n";
+                    break;
+                }
+                std::string input;
+                std::cout << "Enter ticker symbols (comma-separated): ";
+                std::getline(std::cin, input);
+                importJob.start(store, splitTickers(input), apiConfig, false); // Import data from API
+                std::cout << "Import started; keep using the menu while it runs.\n";
+                break;
+            }
+            case 2: {
+                std::string filename;
+                std::cout << "Enter CSV filename (e.g. stocks.csv): ";
+                std::getline(std::cin, filename);
+                importDataFromCSV(store, filename);
+                break;
+            }
+            case 3: {
+                std::string ticker, date;
+                std::cout << "Enter ticker symbol: ";
+                std::getline(std::cin, ticker);
+                std::cout << "Enter date (YYYY-MM-DD): ";
+                std::getline(std::cin, date);
+                StockData stock;
+                if (stockTree.search(ticker, date, stock)) {
+                    std::cout << "\nStock found:\n";
+                    displayStock(stock);
+                } else {
+                    std::cout << "Stock not found!\n";
+                }
+                break;
+            }
+            case 4: {
+                StockData updatedStock = inputStockData();
+                bool updated = false;
+                store.write([&](AVLTree& tree) { updated = tree.update(updatedStock); });
+                if (updated && persistChanges(journal, store)) {
+                    std::cout << "Stock data updated successfully.\n";
+                } else if (updated) {
+                    std::cout << "Stock data updated for this session only; the change will be lost on exit.\n";
+                } else {
+                    std::cout << "Stock not found. Update failed.\n";
+                }
+                break;
+            }
+            case 5: {
+                std::string ticker, date;
+                std::cout << "Enter ticker symbol to remove: ";
+                std::getline(std::cin, ticker);
+                std::cout << "Enter date (YYYY-MM-DD) to remove: ";
+                std::getline(std::cin, date);
+                bool removed = false;
+                store.write([&](AVLTree& tree) { removed = tree.remove(ticker, date); });
+                if (removed && persistChanges(journal, store)) {
+                    std::cout << "Stock data removed successfully.\n";
+                } else if (removed) {
+                    std::cout << "Stock data removed for this session only; the row will come back on the next start.\n";
+                } else {
+                    std::cout << "Stock not found. Removal failed.\n";
+                }
+                break;
+            }
+            case 6: {
+                std::vector<StockData> allStocks = stockTree.getAllStocks();
+                std::cout << "\nAll stocks (" << allStocks.size() << " entries):\n";
+                for (const auto &stock : allStocks) {
+                    displayStock(stock);
+                }
+                SlabStats memory = stockTree.memoryStats();
+                std::cout << "Node memory: " << memory.bytesReserved / 1024 << " KiB in " << memory.slabs
+                          << " slabs, " << memory.blockSize << " bytes per row, peak "
+                          << memory.peakBlocks << " rows\n";
+                break;
+            }
+            case 7: {
+                std::string ticker;
+                std::cout << "Enter ticker symbol: ";
+                std::getline(std::cin, ticker);
+                std::vector<StockData> tickerStocks = stockTree.getStocksByTicker(ticker);
+                std::cout << "\nFound " << tickerStocks.size() << " entries for " << ticker << ":\n";
+                for (const auto &stock : tickerStocks) {
+                    displayStock(stock);
+                }
+                break;
+            }
+            case 8: {
+                std::string ticker, startDate, endDate;
+                std::cout << "Enter ticker symbol: ";
+                std::getline(std::cin, ticker);
+                std::cout << "Enter start date (YYYY-MM-DD): ";
+                std::getline(std::cin, startDate);
+                std::cout << "Enter end date (YYYY-MM-DD): ";
+                std::getline(std::cin, endDate);
+                std::vector<StockData> rangeStocks = stockTree.getStocksByDateRange(ticker, startDate, endDate);
+                std::cout << "\nFound " << rangeStocks.size() << " entries between " 
+                          << startDate << " and " << endDate << ":\n";
+                for (const auto &stock : rangeStocks) {
+                    displayStock(stock);
+                }
+                RangeAggregate summary;
+                if (stockTree.aggregateRange(ticker, startDate, endDate, summary)) {
+                    std::cout << "Open " << summary.firstOpen << ", close " << summary.lastClose
+                              << ", high " << summary.high << ", low " << summary.low
+                              << ", volume " << summary.volume << ", mean close " << summary.meanClose()
+                              << ", close std dev " << std::sqrt(summary.closeVariance()) << "\n";
+                }
+                break;
+            }
+            case 9: {
+                CsvExportFilter filter;
+                std::string input;
+                std::cout << "Enter tickers to export (comma-separated, blank for all): ";
+                std::getline(std::cin, input);
+                if (!input.empty()) filter.tickers = splitTickers(input);
+                std::cout << "Enter start date (YYYY-MM-DD, blank for all): ";
+                std::getline(std::cin, filter.startDate);
+                std::cout << "Enter end date (YYYY-MM-DD, blank for all): ";
+                std::getline(std::cin, filter.endDate);
+                std::string error;
+                if (!CsvExporter::checkDates(filter, error)) {
+                    std::cout << "Not exported: " << error << ". stocks.csv was left unchanged.\n";
+                    break;
+                }
+                exportDataAsCSV(stockTree, filter);
+                break;
+            }
+            case 10: {
+                std::string input;
+                std::cout << "Enter tickers (comma-separated): ";
+                std::getline(std::cin, input);
+                std::vector<std::string> tickers = splitTickers(input);
+                std::cout << "\nComparison Table:\n";
+                printf("%-10s %-12s %-8s %-8s %-8s\n", 
+                       "Ticker", "Date", "Close", "SMA(20)", "Volatility");
+                // Tickers are computed in parallel, then printed in input order
+                Indicators::IndicatorConfig config;
+                std::vector<TickerComparison> results =
+                    compareTickers(stockTree, tickers, config, ThreadPool::shared());
+                for (const auto &result : results) {
+                    for (const auto &row : result.rows) {
+                        printf("%-10s %-12s %-8.2f %-8.2f %-8.2f\n", 
+                               result.ticker.c_str(), DateUtils::toDateString(row.day).c_str(), 
+                               row.close, 
+                               Indicators::valueOr(row.sma, 0),
+                               Indicators::valueOr(row.volatility, 0));
+                    }
+                }
+                break;
+            }
+            case 11: {
+                std::string ticker;
+                std::cout << "Enter ticker symbol: ";
+                std::getline(std::cin, ticker);
+                if (stockTree.scanTicker(ticker).valid()) {
+                    std::cout << "\nFinancial Metrics for " << ticker << ":\n";
+                    std::cout << "20-day SMA: " << metricsCache.sma(ticker, 20) << "\n";
+                    std::cout << "50-day EMA: " << metricsCache.ema(ticker, 50) << "\n";
+                    std::cout << "30-day Volatility: " << metricsCache.volatility(ticker) << "\n";
+                    MetricsCacheStats cacheStats = metricsCache.stats();
+                    std::cout << "(metrics cache: " << cacheStats.hits << " hits, "
+                              << cacheStats.misses << " misses)\n";
+                } else {
+                    std::cout << "No data found for " << ticker << "\n";
+                }
+                break;
+            }
+            case 12: {
+                std::string ticker, date;
+                char action;
+                int quantity;
+                std::cout << "Enter ticker symbol: ";
+                std::getline(std::cin, ticker);
+                std::cout << "Enter trade date (YYYY-MM-DD): ";
+                std::getline(std::cin, date);
+                std::cout << "Buy (B) or Sell (S): ";
+                std::cin >> action;
+                std::cout << "Enter quantity: ";
+                std::cin >> quantity;
+                std::cin.ignore();
+
+                StockData stock;
+                if (stockTree.search(ticker, date, stock)) {
+                    double total = stock.closePrice * quantity;
+                    double commission = CommissionModel()(total);
+                    std::cout << "\nTrade Simulation Results:\n";
+                    std::cout << "---------------------------------\n";
+                    std::cout << "Ticker:        " << stock.ticker << "\n";
+                    std::cout << "Date:          " << stock.date << "\n";
+                    std::cout << "Price:         $" << stock.closePrice << "\n";
+                    std::cout << "Quantity:      " << quantity << "\n";
+                    std::cout << "Commission:    $" << commission << "\n";
+                    std::cout << "Net " << (toupper(action) == 'B' ? "Cost" : "Proceeds") 
+                              << ":    $" << total + commission << "\n";
+                } else {
+                    std::cout << "Stock not found for trade simulation\n";
+                }
+                break;
+            }
+            case 13: {
+                std::string filename, error;
+                std::cout << "Enter snapshot filename (e.g. stocks.snap): ";
+                std::getline(std::cin, filename);
+                if (Snapshot::write(stockTree, filename, error)) {
+                    std::cout << "Snapshot written to " << filename << ".\n";
+                } else {
+                    std::cout << "Snapshot failed: " << error << "\n";
+                }
+                break;
+            }
+            case 14: {
+                std::string filename, error;
+                std::cout << "Enter snapshot filename (e.g. stocks.snap): ";
+                std::getline(std::cin, filename);
+                Snapshot snapshot;
+                if (snapshot.open(filename, true, error)) {
+                    size_t added = 0;
+                    store.write([&](AVLTree& tree) { added = snapshot.loadInto(tree); });
+                    std::cout << "Loaded " << added << " rows from " << filename << ".\n";
+                } else {
+                    std::cout << "Snapshot load failed: " << error << "\n";
+                }
+                break;
+            }
+            case 15: {
+                if (!apiConfigured) {
+                    std::cout << "No API_KEY found in config.txt.\n";
+                    break;
+                }
+                finishImport(importJob, journal, store);
+                if (importJob.running()) {
+                    std::cout << "An API import is already running.\n";
+                    break;
+                }
+                std::string input;
+                std::cout << "Enter ticker symbols (comma-separated, blank for all loaded): ";
+                std::getline(std::cin, input);
+                std::vector<std::string> tickers = input.empty() ? stockTree.getTickers() : splitTickers(input);
+                importJob.start(store, tickers, apiConfig, true); // Fetch only bars newer than what is stored
+                std::cout << "Sync started; keep using the menu while it runs.\n";
+                break;
+            }
+            case 16: {
+                std::string kind, first, second, input;
+                std::cout << "Strategy: SMA crossover (S) or volatility breakout (B): ";
+                std::getline(std::cin, kind);
+                bool crossover = !kind.empty() && toupper(kind[0]) == 'S';
+                std::cout << (crossover ? "Fast SMA periods (comma-separated): " : "Lookback periods (comma-separated): ");
+                std::getline(std::cin, first);
+                std::cout << (crossover ? "Slow SMA periods (comma-separated): " : "Band widths in std devs (comma-separated): ");
+                std::getline(std::cin, second);
+                std::cout << "Enter tickers (comma-separated, blank for all loaded): ";
+                std::getline(std::cin, input);
+
+                std::vector<int> periods;
+                for (const std::string& p : splitTickers(first)) periods.push_back(std::atoi(p.c_str()));
+                std::vector<StrategySpec> strategies;
+                if (crossover) {
+                    std::vector<int> slow;
+                    for (const std::string& p : splitTickers(second)) slow.push_back(std::atoi(p.c_str()));
+                    strategies = smaCrossoverGrid(periods, slow);
+                } else {
+                    std::vector<double> widths;
+                    for (const std::string& k : splitTickers(second)) widths.push_back(std::atof(k.c_str()));
+                    strategies = breakoutGrid(periods, widths);
+                }
+                if (strategies.empty()) {
+                    std::cout << "No valid parameter combinations.\n";
+                    break;
+                }
+                std::vector<std::string> tickers = input.empty() ? stockTree.getTickers() : splitTickers(input);
+                std::vector<StrategyStats> stats =
+                    runBacktests(stockTree, tickers, strategies, BacktestConfig(), ThreadPool::shared());
+                std::sort(stats.begin(), stats.end(), [](const StrategyStats& a, const StrategyStats& b) {
+                    return a.meanReturn > b.meanReturn;
+                });
+                std::cout << "\nBacktest Results (starting cash $100000, best first):\n";
+                printf("%-18s %-8s %-8s %-8s %-10s %-8s %-10s\n",
+                       "Strategy", "Tickers", "Trades", "Win %", "Return %", "Sharpe", "Max DD %");
+                for (const auto &s : stats) {
+                    printf("%-18s %-8zu %-8zu %-8.1f %-10.2f %-8.2f %-10.2f\n",
+                           s.spec.describe().c_str(), s.tickers, s.trades,
+                           s.roundTrips ? 100.0 * s.wins / s.roundTrips : 0.0,
+                           s.meanReturn, s.meanSharpe, s.meanMaxDrawdown);
+                }
+                break;
+            }
+            case 17: {
+                std::string format, filename;
+                std::cout << "Format: JSON (J) or Prometheus (P): ";
+                std::getline(std::cin, format);
+                std::cout << "Save to file (blank to print): ";
+                std::getline(std::cin, filename);
+                bool prometheus = !format.empty() && toupper(format[0]) == 'P';
+                std::ofstream file;
+                if (!filename.empty()) {
+                    file.open(filename);
+                    if (!file.is_open()) {
+                        std::cout << "Cannot write " << filename << "\n";
+                        break;
+                    }
+                }
+                std::ostream& out = filename.empty() ? std::cout : file;
+                if (prometheus) Instrumentation::writePrometheus(out, &stockTree);
+                else Instrumentation::writeJson(out, &stockTree);
+                if (!filename.empty()) std::cout << "Metrics written to " << filename << ".\n";
+                break;
+            }
+            case 18: {
+                std::string ticker, unit;
+                std::cout << "Enter ticker symbol: ";
+                std::getline(std::cin, ticker);
+                std::cout << "Bar size (week, month or N days as e.g. 5d): ";
+                std::getline(std::cin, unit);
+                BarPeriod period;
+                if (!BarPeriod::parse(unit, period)) {
+                    std::cout << "Unrecognized bar size.\n";
+                    break;
+                }
+                std::vector<ResampledBar> bars = barLevels.bars(ticker, period);
+                std::cout << "\n" << bars.size() << " " << period.describe() << " bars for " << ticker << ":\n";
+                for (const ResampledBar& b : bars) {
+                    std::cout << DateUtils::toDateString(b.startDay) << "  O " << b.openPrice
+                              << "  H " << b.highPrice << "  L " << b.lowPrice << "  C " << b.closePrice
+                              << "  V " << b.volume << "  (" << b.rows << " days)\n";
+                }
+                break;
+            }
+            case 19: {
+                std::string input, startDate, endDate;
+                std::cout << "Enter tickers (comma-separated, blank for all): ";
+                std::getline(std::cin, input);
+                std::cout << "Enter start date (YYYY-MM-DD, blank for all): ";
+                std::getline(std::cin, startDate);
+                std::cout << "Enter end date (YYYY-MM-DD, blank for all): ";
+                std::getline(std::cin, endDate);
+                int startDay = INT_MIN, endDay = INT_MAX;
+                if ((!startDate.empty() && !DateUtils::parseDate(startDate, startDay)) ||
+                    (!endDate.empty() && !DateUtils::parseDate(endDate, endDay))) {
+                    std::cout << "Dates must be YYYY-MM-DD.\n";
+                    break;
+                }
+                CorrelationMatrix matrix;
+                std::string error;
+                if (!matrix.build(stockTree, input.empty() ? stockTree.getTickers() : splitTickers(input),
+                                  startDay, endDay, ThreadPool::shared(), error)) {
+                    std::cout << "Cannot compute correlations: " << error << "\n";
+                    break;
+                }
+                std::cout << "\nReturn correlations over " << matrix.observations() << " common days ("
+                          << DateUtils::toDateString(matrix.firstDate()) << " to "
+                          << DateUtils::toDateString(matrix.lastDate()) << "):\n";
+                printf("%-10s", "");
+                for (const auto &name : matrix.tickers()) printf(" %8s", name.c_str());
+                printf("\n");
+                for (size_t i = 0; i < matrix.size(); i++) {
+                    printf("%-10s", matrix.tickers()[i].c_str());
+                    for (size_t j = 0; j < matrix.size(); j++) printf(" %8.3f", matrix.correlation(i, j));
+                    printf("\n");
+                }
+                break;
+            }
+            case 20: {
+                std::string metric, direction, input, startDate, endDate;
+                ScreenQuery query;
+                std::cout << "Rank by return, change, volatility or volume: ";
+                std::getline(std::cin, metric);
+                if (!parseScreenMetric(metric, query.metric)) {
+                    std::cout << "Unknown metric.\n";
+                    break;
+                }
+                std::cout << "Top (T) or bottom (B): ";
+                std::getline(std::cin, direction);
+                query.descending = direction.empty() || toupper(direction[0]) != 'B';
+                std::cout << "How many tickers (blank for 20): ";
+                std::getline(std::cin, input);
+                if (!input.empty()) query.limit = static_cast<size_t>(std::max(0, std::atoi(input.c_str())));
+                std::cout << "Enter start date (YYYY-MM-DD, blank for all): ";
+                std::getline(std::cin, startDate);
+                std::cout << "Enter end date (YYYY-MM-DD, blank for all): ";
+                std::getline(std::cin, endDate);
+                if ((!startDate.empty() && !DateUtils::parseDate(startDate, query.startDay)) ||
+                    (!endDate.empty() && !DateUtils::parseDate(endDate, query.endDay))) {
+                    std::cout << "Dates must be YYYY-MM-DD.\n";
+                    break;
+                }
+                std::cout << "Minimum average daily volume (blank for none): ";
+                std::getline(std::cin, input);
+                if (!input.empty()) query.minAverageVolume = std::atof(input.c_str());
+
+                std::vector<ScreenResult> results = runScreen(stockTree, query, ThreadPool::shared());
+                printf("\n%-5s %-10s %12s %12s %12s %14s\n", "Rank", "Ticker", screenMetricName(query.metric),
+                       "First close", "Last close", "Avg volume");
+                for (size_t i = 0; i < results.size(); i++) {
+                    const ScreenResult& r = results[i];
+                    printf("%-5zu %-10s %12.2f %12.2f %12.2f %14.0f\n", i + 1, r.ticker.c_str(), r.value,
+                           r.firstClose, r.lastClose, r.averageVolume);
+                }
+                if (results.empty()) std::cout << "No tickers matched.\n";
+                break;
+            }
+            case 21:
+                if (importJob.running()) std::cout << "Waiting for the API import to finish...\n";
+                importJob.wait();
+                finishImport(importJob, journal, store);
+                std::cout << "Exiting program...\n";
+                return 0;
+            default:
+                std::cout << "Invalid choice. Please try again.\n";
+        }
+        persistChanges(journal, store);   // imports and snapshot loads become durable here
+        std::cout << "\nPress Enter to continue...";
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        Terminal::clearScreen();
+    }
+    return 0;
+}